@@ -12,335 +12,1709 @@
 #include <iostream>
 #include <string> 
 #include <vector>
-#include <map>
+#include <array>
+#include <algorithm>
 
-#include <cstdlib> // To use srand()
-#include <ctime> // To use srand()
+#include <cstdlib> // To use strtoull()
+#include <ctime> // To use time() as the default seed
+#include <cstring> // To use strlen()
+#include <cmath> // To use sqrt()
+#include <cstdio> // To write the recordings and the CSV histograms
+#include <cstdarg> // To use va_list in renderPrint()
 
 #include <curses.h> // External library to control console screen (e.g. clear just one column of the screen without needing to clear the whole screen and print everything again)
 
 #include <thread> // To define the rotational speed of the columns
 #include <chrono> // To define the rotational speed of the columns
+#include <atomic> // To share the progress of the Ultra-Fast Mode thread (and counters between the threads of the simulators in Tools.cpp)
+#include <mutex> // To tell the screen the Ultra-Fast Mode thread is done (and merge the results of the threads of the simulators in Tools.cpp)
+#include <condition_variable> // To wake the screen up as soon as the Ultra-Fast Mode thread is done
+
+#if !defined(_WIN32)
+#define ANSI_REELS // The reels can be written straight to the terminal with ANSI escape codes (the Windows console of PDCurses doesn't use them)
+#include <unistd.h> // To use write()
+#include <cerrno> // To retry a write() interrupted by a signal
+#endif
 
 using namespace std;
 
-constexpr auto speed = 50; // Defining the speed of the slot machine in miliseconds
-constexpr auto price = 15; // Price to play the game
+constexpr auto speed = 50; // Defining the default speed of the slot machine in miliseconds (how long each frame of the rotating columns lasts)
+constexpr auto price = 15; // Price to play the game
+
+/**
+ * @brief Every symbol of the slot machine. Each cell of the slot only needs one byte, and the name of the symbol is only looked up when it's printed.
+ *
+ */
+enum Symbol : unsigned char { APPLES, BANANA, CHERRY, LEMONS, GRAPES, ORANGE, DIAMOND, MELONS, APRICOT, KIWIS, MANGO, PEACH, PEARS, SYMBOLS };
+
+constexpr const char* symbolCells[SYMBOLS] = { "APPLES ", "BANANA ", "CHERRY ", "LEMONS ", "GRAPES ", "ORANGE ", "DIAMOND", "MELONS ", "APRICOT", "KIWIS  ", "MANGO  ", "PEACH  ", "PEARS  " }; // Static table with the names of the symbols, in the same order as the enum, padded to the 7 characters of a cell so a name fully covers the one that was there before. Printing a symbol just looks its name up here, nothing is allocated
+
+typedef array<Symbol, 7> Column; // The 7 lines of one column of the slot
+typedef array<Column, 3> Reels;  // The 3 columns of the slot
+
+constexpr int stripLength = SYMBOLS; // Nr of symbols on a reel strip. Each symbol is on every strip once, so every symbol is equally likely to stop on the middle line, as the odds (see exactOdds() in Tools.cpp) expect
+
+typedef array<Symbol, stripLength> Strip; // Symbols printed on one reel, in order. The slot shows 7 of them at a time
+
+constexpr Strip reelStrips[3] = { // Reel strips of the 3 columns, each in a different order
+	{ { CHERRY, LEMONS, DIAMOND, BANANA, PEARS, GRAPES, APPLES, MANGO, ORANGE, KIWIS, MELONS, PEACH, APRICOT } },
+	{ { APPLES, DIAMOND, MELONS, BANANA, KIWIS, LEMONS, APRICOT, CHERRY, PEACH, ORANGE, GRAPES, PEARS, MANGO } },
+	{ { BANANA, ORANGE, PEACH, DIAMOND, GRAPES, MELONS, CHERRY, PEARS, APPLES, APRICOT, LEMONS, MANGO, KIWIS } }
+};
+
+/**
+ * @brief Checks that every reel strip has each symbol exactly once, otherwise the odds of the game would change.
+ *
+ * @return true If every strip has each symbol once.
+ */
+constexpr bool stripsHaveEverySymbolOnce() {
+
+	for (int reel = 0; reel < 3; reel++) {
+		for (int symbol = 0; symbol < SYMBOLS; symbol++) {
+			int count = 0;
+
+			for (int i = 0; i < stripLength; i++) {
+				if (reelStrips[reel][i] == symbol) count++;
+			}
+			if (count != 1) return false;
+		}
+	}
+	return true;
+}
+
+static_assert(stripsHaveEverySymbolOnce(), "Every reel strip must have each symbol exactly once");
+
+/**
+ * @brief Back buffer of the area of the slot where the symbols are shown. It remembers what's on the screen, so each frame only sends the cells that changed.
+ *
+ */
+struct ReelArea {
+	Reels shown;                   // Symbols on the screen right now
+	bool valid = false;            // False when the screen has been cleared, so every cell has to be drawn again
+	unsigned long long frames = 0; // Nr of frames drawn
+	unsigned long long cells = 0;  // Nr of cells sent to the terminal
+	unsigned long long bytes = 0;  // Nr of bytes sent to the terminal. Measured by the ANSI writer, estimated with cellBytes for the cells drawn with curses
+	bool estimated = false;        // True once a frame was drawn with curses, so bytes is (partly) an estimate
+};
+
+constexpr int cellBytes = 15; // Estimate of the bytes curses needs to send a cell: moving the cursor (ESC[yy;xxH, 8 bytes) and the 7 characters of the cell. Curses doesn't say what it really sends, it can skip the cursor move between neighbouring cells
+
+ReelArea reelArea; // Back buffer of the symbols on the screen
+
+/**
+ * @brief Fast path for the reel area: the changed cells of a frame are written to the terminal as ANSI escape codes with a single write(), without going through curses.
+ *
+ */
+struct AnsiReels {
+	bool enabled = false;          // True to use it, with --ansi-reels
+	int output = 1;                // File descriptor of the terminal
+	unsigned long long writes = 0; // Nr of write() calls made
+	unsigned long long bytes = 0;  // Nr of bytes written
+};
+
+AnsiReels ansiReels;
+
+int framesPerSecond = 1000 / speed; // Frame rate of the rotating columns. It can be changed with --fps
+
+constexpr int frameTimeBuckets = 2000; // The frame times are kept in a histogram of 0.1ms buckets, up to 200ms (longer frames go in the last bucket)
+
+/**
+ * @brief Frame scheduler of the rotating columns. Each frame ends at an absolute deadline, so the time spent rendering and reading the keyboard doesn't add up and make the columns slower.
+ *
+ */
+struct FrameClock {
+	chrono::steady_clock::time_point deadline;            // When the current frame has to end
+	chrono::steady_clock::time_point frameStart;          // When the current frame started
+	bool running = false;                                 // False until the clock is started for a spin
+	unsigned long long frames = 0;                        // Nr of frames measured
+	unsigned long long skipped = 0;                       // Nr of frames skipped because the rendering fell behind
+	unsigned long long frameTimes[frameTimeBuckets] = {}; // Histogram of how long each frame really took
+};
+
+FrameClock frameClock; // Frame scheduler of the rotating columns. Declared as global variable so it keeps the stats of the whole game
+
+/**
+ * @brief Everything a spin needs. It's created once per session and passed by reference to every function of the spin, so a spin doesn't copy or allocate anything.
+ *
+ */
+struct SpinState {
+	Reels reels = {};              // Symbols of the 3 columns, filled in as each column gets locked
+	array<int, 3> offsets = {};    // Position of each reel strip, i.e. the symbol on the top line. The reels stay where they stopped for the next spin
+	int stopping = -1;             // Reel that is still turning to the stop picked for it, -1 if none
+	int stop = 0;                  // Position the stopping reel stops at
+};
+
+int autoContinue = -1; // Miliseconds the result of a Fast Mode game stays on the screen before the next game starts by itself. -1 (default) waits for a key. It can be changed with --auto-continue
+
+constexpr int startingCredit = 100; // Credit the player starts with
+
+int credit = startingCredit; // Initial credit. Declared as global variable so every function can access it without having to receive it as an argument
+/**
+ * @brief Every prize of the game, from the worst to the best.
+ *
+ */
+enum Prize : unsigned char { NO_PRIZE, TWO_SYMBOLS, ONE_DIAMOND, TWO_SYMBOLS_DIAMOND, TWO_DIAMONDS, JACKPOT, DIAMOND_JACKPOT, PRIZES };
+
+constexpr int prizePoints[PRIZES] = { 0, 10, 50, 60, 110, 150, 1000 }; // Points of each prize, in the same order as the enum
+
+const char* const prizeNames[PRIZES] = { "Nothing", "2 Symbols", "DIAMOND", "2 Symbols + DIAMOND", "2 DIAMONDs", "Jackpot", "DIAMOND Jackpot" }; // Names of the prizes, in the same order as the enum
+
+const char* const prizeMessages[PRIZES] = {
+	"Bad luck... Maybe next time!",
+	"Congrats!! You got two symbols!",
+	"At least you got a DIAMOND!",
+	"Congrats!! You got two symbols AND a DIAMOND!",
+	"Congrats!! You got two symbols and they are both a DIAMOND!",
+	"=====>   JACKPOT!!!   <=====",
+	"=====>   OMG A DIAMOND JACKPOT!!!   <====="
+}; // Message shown for each prize, in the same order as the enum
+
+/**
+ * @brief Finds which prize is worth the given amount of points.
+ *
+ * @param points Amount of points of a spin.
+ * @return Prize Returns the prize, or PRIZES if no prize is worth that amount.
+ */
+constexpr Prize prizeOf(int points) {
+
+	for (int prize = 0; prize < PRIZES; prize++) {
+		if (prizePoints[prize] == points) return Prize(prize);
+	}
+	return PRIZES;
+}
+
+/**
+ * @brief Counters with the nr of occurrences of each result and the cash-flow. Each counter is a 64-bit field, so long simulations can't overflow them, and the whole struct fits in one cache line.
+ *
+ */
+struct alignas(64) Counters {
+	long long jackpots = 0;   // Nr occurrences of Jackpots
+	long long twoSymbols = 0; // Nr occurrences of 2 Symbols
+	long long diamonds = 0;   // Nr occurrences of Diamonds
+	long long total = 0;      // Nr of games played
+	long long spent = 0;      // Nr of credits spent
+	long long earned = 0;     // Nr of credits earned
+};
+
+static_assert(sizeof(Counters) == 64, "The counters must fit in one cache line");
+
+/**
+ * @brief Nr of games that ended with each prize. The mean, variance and hit frequencies are worked out from them (see summarizeStats). They don't fit in the cache line of the counters, so they are kept apart.
+ *
+ */
+struct PrizeTiers {
+	long long tiers[PRIZES] = {}; // Nr of games of each prize, in the same order as the enum
+};
+
+/**
+ * @brief Stats of a set of games: the counters in their own cache line, followed by the nr of games of each prize in the next ones. The fields of both are used directly (e.g. stats.total, stats.tiers[JACKPOT]).
+ *
+ */
+struct Stats : Counters, PrizeTiers {
+};
+
+static_assert(sizeof(Stats) == 2 * sizeof(Counters), "The prize tiers must fit in the cache line after the counters");
+
+/**
+ * @brief Name of one of the counters of the Stats struct, to find it by name when the stats are displayed or exported.
+ *
+ */
+struct StatName {
+	const char* name;          // Name of the counter
+	long long Stats::* value;  // Which field of the Stats struct it is
+	const char* sentence;      // Sentence used to show the counter in displayStats()
+};
+
+constexpr StatName statNames[] = {
+	{ "Total", &Stats::total, "You played a Total of %lld game(s)." },
+	{ "Jackpots", &Stats::jackpots, "You got a Jackpot in %lld of them." },
+	{ "2Symbols", &Stats::twoSymbols, "You got 2 Symbols in %lld of them." },
+	{ "Diamonds", &Stats::diamonds, "And you got Diamonds %lld time(s)." },
+	{ "Spent", &Stats::spent, "You spent %lld credits." },
+	{ "Earned", &Stats::earned, "And you earned %lld credits." }
+}; // Name-indexed view of the stats. Only used to display and export them, the game itself uses the fields directly
+
+/**
+ * @brief Mean, variance and RTP of the games counted in a Stats. Each game pays one of the 7 prizes, so the sum and the sum of squares of the net results are known exactly from the nr of games of each prize, and they are worked out only when they are shown.
+ * Counting a game is a single increment (O(1), nothing more for Ultra-Fast Mode and the simulators) and two Stats can be merged by just adding them.
+ *
+ */
+struct StatsSummary {
+	double meanNet = 0;   // Mean net result of a game (prize - price)
+	double deviation = 0; // Standard deviation of the net result of a game
+	double rtp = 0;       // Observed RTP (what was earned / what was spent)
+	double rtpMargin = 0; // Half width of the 95% confidence interval of the RTP
+};
+
+/**
+ * @brief Works out the mean, standard deviation and RTP (with its 95% confidence interval) of the games counted in a Stats.
+ *
+ * @param tally Stats to summarize.
+ * @return StatsSummary Returns the summary. Everything is 0 if no games were played.
+ */
+StatsSummary summarizeStats(const Stats& tally) {
+
+	StatsSummary summary;
+	long long games = 0;
+	double sum = 0, squares = 0;
+
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		double net = prizePoints[prize] - price;
+
+		games += tally.tiers[prize];
+		sum += tally.tiers[prize] * net;
+		squares += tally.tiers[prize] * net * net;
+	}
+
+	if (games == 0) return summary;
+
+	summary.meanNet = sum / games;
+	if (games > 1) summary.deviation = sqrt(max((squares - sum * summary.meanNet) / (games - 1), 0.0)); // Sample variance
+	summary.rtp = 1 + summary.meanNet / price;
+	summary.rtpMargin = 1.96 * summary.deviation / price / sqrt((double)games); // Normal approximation, fine for the nr of games needed to get a useful interval
+	return summary;
+}
+
+constexpr int histogramSubBuckets = 16; // Each power of 2 is split in this many buckets, so a bucket is never more than 1/16 (6.25%) of the values in it wide
+constexpr int histogramBuckets = (64 - 3) * histogramSubBuckets; // Enough buckets for any 64-bit value. Values below 2 * histogramSubBuckets get a bucket each
+
+/**
+ * @brief Histogram of lengths (e.g. of sessions, in games) with log-sized buckets, like an HDR histogram: small values are counted exactly and big ones in buckets that grow with them.
+ * It has a fixed size (under 8KB) no matter how many values are counted, and two histograms can be merged by adding their buckets, e.g. the ones of the threads of a simulation.
+ *
+ */
+struct LengthHistogram {
+	unsigned long long counts[histogramBuckets] = {}; // Nr of values in each bucket
+	unsigned long long values = 0;                    // Nr of values counted
+	unsigned long long longest = 0;                   // Biggest value counted
+};
+
+/**
+ * @brief Finds the highest bit set of a number, i.e. the integer part of its base 2 logarithm.
+ *
+ * @param value Number, bigger than 0.
+ * @return int Returns the position of the highest bit set (0-63).
+ */
+int highestBit(unsigned long long value) {
+
+	int bit = 0;
+
+	for (int step = 32; step > 0; step /= 2) { // Binary search, 6 steps
+		if (value >> step) {
+			value >>= step;
+			bit += step;
+		}
+	}
+	return bit;
+}
+
+/**
+ * @brief Finds the bucket of the histogram where a value is counted.
+ *
+ * @param value Value to count.
+ * @return int Returns the index of the bucket.
+ */
+int histogramBucket(unsigned long long value) {
+
+	if (value < 2 * histogramSubBuckets) return (int)value;
+
+	int magnitude = highestBit(value); // 5 or more
+	int subBucket = (int)(value >> (magnitude - 4)) & (histogramSubBuckets - 1);
+
+	return (magnitude - 3) * histogramSubBuckets + subBucket;
+}
+
+/**
+ * @brief Finds the smallest value counted in a bucket of the histogram.
+ *
+ * @param bucket Index of the bucket.
+ * @return unsigned long long Returns the smallest value of the bucket.
+ */
+unsigned long long histogramLow(int bucket) {
+
+	if (bucket < 2 * histogramSubBuckets) return bucket;
+
+	int magnitude = bucket / histogramSubBuckets + 3;
+
+	return (unsigned long long)(histogramSubBuckets + bucket % histogramSubBuckets) << (magnitude - 4);
+}
+
+/**
+ * @brief Finds the biggest value counted in a bucket of the histogram.
+ *
+ * @param bucket Index of the bucket.
+ * @return unsigned long long Returns the biggest value of the bucket.
+ */
+unsigned long long histogramHigh(int bucket) {
+
+	if (bucket < 2 * histogramSubBuckets) return bucket;
+
+	return histogramLow(bucket) + (1ULL << (bucket / histogramSubBuckets - 1)) - 1;
+}
+
+/**
+ * @brief Counts a value in the histogram.
+ *
+ * @param histogram Histogram where the value is counted.
+ * @param value Value to count.
+ */
+void recordLength(LengthHistogram& histogram, unsigned long long value) {
+
+	histogram.counts[histogramBucket(value)]++;
+	histogram.values++;
+	histogram.longest = max(histogram.longest, value);
+}
+
+/**
+ * @brief Adds the values counted in one histogram to another.
+ *
+ * @param total Histogram where the values are added.
+ * @param part Histogram to add.
+ */
+void mergeHistogram(LengthHistogram& total, const LengthHistogram& part) {
+
+	for (int bucket = 0; bucket < histogramBuckets; bucket++) {
+		total.counts[bucket] += part.counts[bucket];
+	}
+	total.values += part.values;
+	total.longest = max(total.longest, part.longest);
+}
+
+/**
+ * @brief Finds a percentile of the values counted in the histogram.
+ *
+ * @param histogram Histogram to look in.
+ * @param percentile Percentile to find, between 0 and 1.
+ * @return unsigned long long Returns the biggest value of the bucket where the percentile is (never more than the biggest value counted), or 0 if the histogram is empty.
+ */
+unsigned long long histogramPercentile(const LengthHistogram& histogram, double percentile) {
+
+	unsigned long long target = max((unsigned long long)ceil(histogram.values * percentile), 1ULL);
+	unsigned long long seen = 0;
+
+	for (int bucket = 0; bucket < histogramBuckets && histogram.values > 0; bucket++) {
+		seen += histogram.counts[bucket];
+		if (seen >= target) return min(histogramHigh(bucket), histogram.longest);
+	}
+	return 0;
+}
+
+/**
+ * @brief Writes the payout histogram (games of each prize), the session length histogram and the highest credit histogram (if there is one) to a CSV file, one bucket per row, to plot them with other tools.
+ *
+ * @param path File to write.
+ * @param tally Stats with the games of each prize.
+ * @param sessions Lengths of the sessions, in games.
+ * @param peaks Optional parameter. Highest credit of every session, NULL if there isn't one.
+ * @return true If the file was written.
+ * @return false If the file couldn't be created.
+ */
+bool exportHistograms(const char* path, const Stats& tally, const LengthHistogram& sessions, const LengthHistogram* peaks = NULL) {
+
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL) return false;
+
+	fprintf(file, "histogram,low,high,count\n");
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		fprintf(file, "payout,%d,%d,%lld\n", prizePoints[prize], prizePoints[prize], tally.tiers[prize]);
+	}
+	for (int bucket = 0; bucket < histogramBuckets; bucket++) {
+		if (sessions.counts[bucket] > 0) fprintf(file, "session_length,%llu,%llu,%llu\n", histogramLow(bucket), histogramHigh(bucket), sessions.counts[bucket]);
+	}
+	for (int bucket = 0; peaks != NULL && bucket < histogramBuckets; bucket++) {
+		if (peaks->counts[bucket] > 0) fprintf(file, "peak_credit,%llu,%llu,%llu\n", histogramLow(bucket), histogramHigh(bucket), peaks->counts[bucket]);
+	}
+	return fclose(file) == 0;
+}
+
+Stats stats; // Nr of occurrences of each result and cash-flow. Declared as global variable so every function can access it without having to receive it as an argument
+
+Stats sessionStats; // Stats of all the games since the program started (stats only has the ones since the player last chose a mode)
+
+LengthHistogram sessionLengths; // Nr of games each session lasted until the credit ran out
+
+/**
+ * @brief Where the screen is drawn. Every drawing function of the game goes through the render functions below, so the game can also run without a terminal.
+ *
+ */
+enum RendererBackend : unsigned char {
+	CURSES_RENDERER,    // Draws on the terminal with curses
+	NULL_RENDERER,      // Discards everything, to measure the game logic alone
+	RECORDING_RENDERER, // Draws on the terminal and also writes every frame to a recording file
+	RENDERERS
+};
+
+constexpr const char* rendererNames[RENDERERS] = { "curses", "null", "record" };
+
+constexpr int recordingLimit = 0xFFFF; // Highest line, column and length of text a recording can hold (they take 2 bytes)
+
+/**
+ * @brief State of the renderer. The recording file starts with "FMREC2", the nr of lines and columns of the screen (2 bytes each), and is followed by one record per drawing operation:
+ * 'T' line column length text, 'M' line column length text (text with something measured, like a time or a speed, that --compare doesn't compare), 'L' line (clear a line), 'E' (erase the screen), 'C' (clear and repaint the screen) and 'F' time (end of a frame, 8 bytes with the microseconds since the recording started).
+ * Lines, columns and lengths take 2 bytes, so they can be up to 65535 (longer texts are cut). Numbers are little-endian.
+ *
+ */
+struct Renderer {
+	RendererBackend backend = CURSES_RENDERER;
+	FILE* recording = NULL;                    // File being recorded, only used by the recording backend
+	chrono::steady_clock::time_point start;    // When the recording started
+	unsigned long long frames = 0;             // Nr of frames recorded
+};
+
+Renderer renderer;
+
+/**
+ * @brief Writes a number to the recording file.
+ *
+ * @param value Number to write.
+ * @param bytes Nr of bytes to write it with, least significant first.
+ */
+void recordNumber(unsigned long long value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		putc((value >> (8 * i)) & 0xFF, renderer.recording);
+	}
+}
+
+/**
+ * @brief Starts recording everything the game draws. The game is still drawn on the terminal.
+ *
+ * @param path File to record to.
+ * @return true If the file was created.
+ * @return false If the file couldn't be created.
+ */
+bool startRecording(const char* path) {
+
+	renderer.recording = fopen(path, "wb");
+
+	if (renderer.recording == NULL) return false;
+
+	renderer.backend = RECORDING_RENDERER;
+	renderer.start = chrono::steady_clock::now();
+	renderer.frames = 0;
+
+	fputs("FMREC2", renderer.recording);
+	recordNumber(min(LINES, recordingLimit), 2);
+	recordNumber(min(COLS, recordingLimit), 2);
+	return true;
+}
+
+/**
+ * @brief Stops the recording and closes its file.
+ *
+ */
+void stopRecording() {
+
+	if (renderer.recording == NULL) return;
+
+	fclose(renderer.recording);
+	renderer.recording = NULL;
+	renderer.backend = CURSES_RENDERER;
+}
+
+/**
+ * @brief Writes a 'T' or 'M' record (text drawn on the screen) to the recording file.
+ *
+ * @param line Line of the screen.
+ * @param column Column of the screen.
+ * @param text Text drawn.
+ * @param length Nr of characters of the text.
+ * @param type Optional parameter. 'M' if the text has something measured in it, 'T' (default) if it doesn't.
+ */
+void recordText(int line, int column, const char* text, size_t length, char type = 'T') {
+
+	length = min(length, (size_t)recordingLimit);
+
+	putc(type, renderer.recording);
+	recordNumber(min(max(line, 0), recordingLimit), 2);
+	recordNumber(min(max(column, 0), recordingLimit), 2);
+	recordNumber(length, 2);
+	fwrite(text, 1, length, renderer.recording);
+}
+
+/**
+ * @brief Writes text on the screen.
+ *
+ * @param line Line of the screen.
+ * @param column Column of the screen.
+ * @param text Text to write.
+ */
+void renderText(int line, int column, const char* text) {
+
+	if (renderer.backend != NULL_RENDERER) mvaddstr(line, column, text);
+
+	if (renderer.backend == RECORDING_RENDERER) recordText(line, column, text, strlen(text));
+}
+
+/**
+ * @brief Writes formatted text on the screen, like printf.
+ *
+ * @param line Line of the screen.
+ * @param column Column of the screen.
+ * @param format Format of the text, as in printf.
+ */
+void renderPrint(int line, int column, const char* format, ...) {
+
+	if (renderer.backend == NULL_RENDERER) return; // Not even formatted, so only the game logic is measured
+
+	char text[256];
+	va_list arguments;
+
+	va_start(arguments, format);
+	vsnprintf(text, sizeof(text), format, arguments);
+	va_end(arguments);
+
+	renderText(line, column, text);
+}
+
+/**
+ * @brief Writes formatted text with something measured in it (a time, a speed...) on the screen, like renderPrint. It's recorded as 'M', so two recordings of the same session can still be compared even though the measurements are always a bit different.
+ *
+ * @param line Line of the screen.
+ * @param column Column of the screen.
+ * @param format Format of the text, as in printf.
+ */
+void renderMeasured(int line, int column, const char* format, ...) {
+
+	if (renderer.backend == NULL_RENDERER) return;
+
+	char text[256];
+	va_list arguments;
+
+	va_start(arguments, format);
+	vsnprintf(text, sizeof(text), format, arguments);
+	va_end(arguments);
+
+	mvaddstr(line, column, text);
+	if (renderer.backend == RECORDING_RENDERER) recordText(line, column, text, strlen(text), 'M');
+}
+
+/**
+ * @brief Clears specific lines in the console while keeping everything else untouched.
+ *
+ * @param line to clean
+ */
+void clearLine(int line) {
+
+	if (renderer.backend != NULL_RENDERER) {
+		int y, x;            // To store current position of the cursor
+		getyx(stdscr, y, x); // Store current position of the cursor
+		move(line, 0);       // Move to begining of line to clear
+		clrtoeol();          // Clear line
+		move(y, x);          // Move back to saved position
+	}
+
+	if (renderer.backend == RECORDING_RENDERER) {
+		putc('L', renderer.recording);
+		recordNumber(min(max(line, 0), recordingLimit), 2);
+	}
+}
+
+/**
+ * @brief Erases the screen. The next frame only sends what changed.
+ *
+ */
+void renderErase() {
+
+	if (renderer.backend != NULL_RENDERER) erase();
+
+	if (renderer.backend == RECORDING_RENDERER) putc('E', renderer.recording);
+}
+
+/**
+ * @brief Clears the screen. The next frame repaints the whole terminal.
+ *
+ */
+void renderClear() {
+
+	if (renderer.backend != NULL_RENDERER) clear();
+
+	if (renderer.backend == RECORDING_RENDERER) putc('C', renderer.recording);
+}
+
+/**
+ * @brief Shows everything drawn since the last frame.
+ *
+ */
+void renderPresent() {
+
+	if (renderer.backend != NULL_RENDERER) refresh();
+
+	if (renderer.backend == RECORDING_RENDERER) {
+		putc('F', renderer.recording);
+		recordNumber((unsigned long long)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - renderer.start).count(), 8);
+		renderer.frames++;
+	}
+}
+
+/**
+ * @brief Shows or hides the cursor of the terminal. The cursor isn't part of the frames, so it isn't recorded.
+ *
+ * @param visible True to show it, false to hide it.
+ * @param line Optional parameter. Line where the cursor is moved to when it's shown.
+ * @param column Optional parameter. Column where the cursor is moved to when it's shown.
+ */
+void renderCursor(bool visible, int line = 0, int column = 0) {
+
+	if (renderer.backend == NULL_RENDERER) return; // There's no terminal (curses was never started)
+
+	curs_set(visible ? 1 : 0);
+	if (visible) move(line, column);
+}
+
+/**
+ * @brief Gives the terminal back to the shell at the end of the game.
+ *
+ */
+void renderEnd() {
+
+	if (renderer.backend != NULL_RENDERER) endwin();
+}
+
+/**
+ * @brief Static parts of the screen, drawn once into curses pads and copied to the screen when needed. Copying a pad doesn't send anything to the terminal by itself, the next refresh only sends what really changed.
+ *
+ */
+struct StaticLayers {
+	WINDOW* logo = NULL;  // ASCII art on the top
+	WINDOW* frame = NULL; // Structure of the slot, lever and help text
+};
+
+constexpr int frameLayerLine = 8;    // Line of the screen where the frame layer starts
+constexpr int frameLayerColumn = 33; // Column of the screen where the frame layer starts
+
+StaticLayers staticLayers; // Pads with the static parts of the screen, built the first time they are needed
+
+/**
+ * @brief Draws the static parts of the screen into their pads. Only does something the first time it's called (or after freeLayers).
+ *
+ */
+void buildLayers() {
+
+	if (staticLayers.logo != NULL || renderer.backend == NULL_RENDERER) return;
+
+	staticLayers.logo = newpad(8, 110);
+	mvwaddstr(staticLayers.logo, 0, 0, R"(
+		 _____                  _   _      __  __                  _       _
+		|  ___|  _ __   _   _  (_) | |_   |  \/  |   __ _    ___  | |__   (_)  _ __     ___
+		| |_    | '__| | | | | | | | __|  | |\/| |  / _` |  / __| | '_ \  | | | '_ \   / _ \
+		|  _|   | |    | |_| | | | | |_   | |  | | | (_| | | (__  | | | | | | | | | | |  __/
+		|_|     |_|     \__,_| |_|  \__|  |_|  |_|  \__,_|  \___| |_| |_| |_| |_| |_|  \___|
+
+
+)");
+	mvwaddstr(staticLayers.logo, 6, 86, "by Vasco Pinto");
+
+	WINDOW* frame = staticLayers.frame = newpad(11, 52); // Coordinates are relative to (frameLayerLine, frameLayerColumn)
+
+	for (unsigned short int i = 0; i < 11; i++) {
+		if (i == 0 || i == 10) { // If it's the top or bottom
+			mvwaddstr(frame, i, 0, "#################################");
+		}
+		else if (i == 5) { // If it's the middle
+			mvwaddstr(frame, i, 0, "#==>|                       |<==#");
+		}
+		else {
+			mvwaddstr(frame, i, 0, "#                               #");
+		}
+	}
+
+	mvwaddstr(frame, 1, 40, R"( ___ (@) )");
+	mvwaddstr(frame, 2, 40, R"(|.-.|/ )");
+	mvwaddstr(frame, 3, 40, R"(|| |/ )");
+	mvwaddstr(frame, 4, 40, R"(|| /|)");
+	mvwaddstr(frame, 5, 40, R"(||/||)");
+	mvwaddstr(frame, 6, 40, R"(|| ||)");
+	mvwaddstr(frame, 7, 40, R"(|| ||)");
+	mvwaddstr(frame, 8, 40, R"('---')");
+
+	mvwaddstr(frame, 9, 35, "Press [ENTER] to");
+	mvwaddstr(frame, 10, 35, "lock each column");
+}
+
+/**
+ * @brief Deletes the pads of the static layers. Needed before the curses screen they belong to is closed.
+ *
+ */
+void freeLayers() {
+
+	if (staticLayers.logo == NULL) return;
+
+	delwin(staticLayers.logo);
+	delwin(staticLayers.frame);
+	staticLayers = StaticLayers();
+}
+
+/**
+ * @brief Copies a static layer to the screen, cut to the size of the screen.
+ *
+ * @param layer Pad to copy.
+ * @param line Line of the screen where the layer starts.
+ * @param column Column of the screen where the layer starts.
+ */
+void drawLayer(WINDOW* layer, int line, int column) {
+
+	if (renderer.backend == NULL_RENDERER) return; // The layers aren't built without a terminal
+
+	int lastLine = min(line + getmaxy(layer), LINES) - 1;
+	int lastColumn = min(column + getmaxx(layer), COLS) - 1;
+
+	if (lastLine < line || lastColumn < column) return;
+
+	copywin(layer, stdscr, 0, 0, line, column, lastLine, lastColumn, FALSE);
+
+	if (renderer.backend == RECORDING_RENDERER) { // The pad isn't in the recording, so its lines are recorded as text
+		char text[256];
+
+		for (int i = 0; i <= lastLine - line; i++) {
+			mvwinnstr(layer, i, 0, text, min(lastColumn - column + 1, 255));
+			recordText(line + i, column, text, strlen(text));
+		}
+	}
+}
+
+/**
+ * @brief Copies the ASCII art on the top and the amount of credits left on the bottom left corner to the screen, without refreshing it.
+ *
+ */
+void drawBanner() {
+
+	buildLayers();
+	drawLayer(staticLayers.logo, 0, 0);
+
+	clearLine(LINES - 2);
+
+	renderPrint(LINES - 2, COLS - 15, "Credit = %d", credit);
+}
+
+/**
+ * @brief Prints the ASCII art on the top and shows the amount of credits left on the bottom left corner.
+ *
+ */
+void banner() {
+
+	drawBanner();
+
+	renderPresent();
+}
+
+/**
+ * @brief Starts a new screen: erases the previous one and copies the banner, without refreshing. Like printFrame(), it erases instead of clearing, so when the screen is shown only what changed is sent instead of repainting the whole terminal.
+ *
+ */
+void newScreen() {
+
+	renderErase();
+	reelArea.valid = false; // The reel area was erased too
+
+	drawBanner();
+}
+
+/**
+ * @brief Prints the structer of the slot as well as the ASCII art representing a lever.
+ *
+ */
+void printFrame() {
+
+	renderErase(); // Unlike clear(), the next refresh only sends what changed instead of repainting the whole screen
+	reelArea.valid = false; // The reel area was erased, so the symbols will all be drawn again
+
+	drawBanner(); // The logo and the credit, refreshed together with the frame
+
+	drawLayer(staticLayers.frame, frameLayerLine, frameLayerColumn);
+
+	renderPresent();
+}
+
+/**
+ * @brief Key press of an input script.
+ *
+ */
+struct ScriptEvent {
+	bool timed;     // True if it happens some miliseconds after the previous key, false if it happens some frames after it
+	long long when; // Nr of frames or miliseconds after the previous key
+	int key;        // Key pressed
+};
+
+/**
+ * @brief Input script that replaces the keyboard, so a session can be played again exactly the same way (together with --seed).
+ *
+ */
+struct InputScript {
+	vector<ScriptEvent> events;                   // Key presses, in order
+	size_t next = 0;                              // Next key press to happen
+	bool active = false;                          // True while the keys come from the script
+	int pushedBack = ERR;                         // Key given back with unreadKey(), returned again by the next readKey()
+	unsigned long long lastFrame = 0;             // Frame of the previous key press
+	chrono::steady_clock::time_point lastTime;    // Time of the previous key press
+	chrono::steady_clock::time_point start;       // When the script started
+};
+
+InputScript inputScript;
+
+/**
+ * @brief Loads an input script. Each line has when a key is pressed and the key: "12 a" presses 'a' 12 frames of the rotating columns after the previous key and "1500ms a" presses it 1500 miliseconds after the previous key.
+ * Keys are single characters, "enter" or "space". Empty lines and lines starting with '#' are ignored.
+ *
+ * @param path File with the script.
+ * @return true If the script was loaded.
+ * @return false If the file couldn't be read or has a line that isn't valid.
+ */
+bool loadInputScript(const char* path) {
+
+	FILE* file = fopen(path, "r");
+
+	if (file == NULL) return false;
+
+	char line[256];
+	bool valid = true;
+
+	while (valid && fgets(line, sizeof(line), file) != NULL) {
+		char when[32], key[32];
+
+		if (line[0] == '#' || sscanf(line, "%31s", when) != 1) continue; // Comment or empty line
+
+		ScriptEvent event;
+		char* unit;
+
+		valid = sscanf(line, "%31s %31s", when, key) == 2;
+		if (!valid) break;
+
+		event.when = strtoll(when, &unit, 10);
+		event.timed = strcmp(unit, "ms") == 0;
+		valid = unit != when && event.when >= 0 && (event.timed || *unit == '\0');
+
+		if (strlen(key) == 1) event.key = key[0];
+		else if (strcmp(key, "enter") == 0) event.key = '\n';
+		else if (strcmp(key, "space") == 0) event.key = ' ';
+		else valid = false;
+
+		inputScript.events.push_back(event);
+	}
+	fclose(file);
+
+	if (!valid) return false;
 
-int credit = 100; // Initial credit. Declared as global variable so every function can access it without having to receive it as an argument
-map<string, int> stats; // Pair of values to store nr of occurrences of a result and cash-flow. Declared as global variable so every function can access it without having to receive it as an argument
+	inputScript.active = true;
+	inputScript.start = inputScript.lastTime = chrono::steady_clock::now();
+	return true;
+}
 
 /**
- * @brief Clears specific lines in the console while keeping everything else untouched.
+ * @brief Gives the next key of the input script, if it's time for it.
  *
- * @param line to clean
+ * @param timeoutMs How long to wait for the key, in miliseconds. 0 only checks if it's time for the key and -1 waits until it is.
+ * @return int Returns the key, or ERR if it isn't time for it yet.
  */
-void clearLine(int line) {
-	int y, x;            // To store current position of the cursor
-	getyx(stdscr, y, x); // Store current position of the cursor
-	move(line, 0);       // Move to begining of line to clear
-	clrtoeol();          // Clear line
-	move(y, x);          // Move back to saved position
+int scriptKey(int timeoutMs) {
+
+	const ScriptEvent& event = inputScript.events[inputScript.next];
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	bool due;
+
+	if (event.timed) {
+		chrono::steady_clock::time_point time = inputScript.lastTime + chrono::milliseconds(event.when);
+
+		due = now >= time;
+		if (!due && (timeoutMs < 0 || time <= now + chrono::milliseconds(timeoutMs))) { // The key comes before the timeout
+			this_thread::sleep_until(time);
+			due = true;
+		}
+	}
+	else { // While waiting for a key no frames are drawn, so a blocking wait gets the key straight away
+		due = frameClock.frames - inputScript.lastFrame >= (unsigned long long)event.when || timeoutMs < 0;
+	}
+
+	if (!due) {
+		if (timeoutMs > 0) this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+		return ERR;
+	}
+
+	inputScript.next++;
+	inputScript.lastFrame = frameClock.frames;
+	inputScript.lastTime = chrono::steady_clock::now();
+	return event.key;
 }
 
 /**
- * @brief Prints the ASCII art on the top and shows the amount of credits left on the bottom left corner.
+ * @brief Reads a key from the keyboard. The program sleeps until a key is pressed or the time is up (curses waits on the input instead of asking for it again and again), so waiting in a menu doesn't use the CPU.
  *
+ * @param timeoutMs How long to wait for a key, in miliseconds. 0 only checks if a key was already pressed and -1 waits forever.
+ * @return int Returns the key pressed, or ERR if no key was pressed in time.
  */
-void banner() {
+int readKey(int timeoutMs = -1) {
 
-	mvaddstr(0, 0, R"(
-		 _____                  _   _      __  __                  _       _
-		|  ___|  _ __   _   _  (_) | |_   |  \/  |   __ _    ___  | |__   (_)  _ __     ___
-		| |_    | '__| | | | | | | | __|  | |\/| |  / _` |  / __| | '_ \  | | | '_ \   / _ \
-		|  _|   | |    | |_| | | | | |_   | |  | | | (_| | | (__  | | | | | | | | | | |  __/
-		|_|     |_|     \__,_| |_|  \__|  |_|  |_|  \__,_|  \___| |_| |_| |_| |_| |_|  \___|
+	if (inputScript.pushedBack != ERR) {
+		int key = inputScript.pushedBack;
 
+		inputScript.pushedBack = ERR;
+		return key;
+	}
 
-)");
-	mvaddstr(6, 86, "by Vasco Pinto");
+	if (inputScript.active) {
+		if (inputScript.next < inputScript.events.size()) return scriptKey(timeoutMs);
 
-	clearLine(LINES - 2);
+		inputScript.active = false; // The script is over, the keyboard takes over
+
+		if (renderer.backend == NULL_RENDERER) { // There's no keyboard without a screen
+			cout << "The input script ended before the game did" << endl;
+			exit(1);
+		}
+	}
 
-	mvprintw(LINES - 2, COLS - 15, "Credit = %d", credit);
+	timeout(timeoutMs);
 
-	refresh();
+	return getch();
 }
 
 /**
- * @brief Prints the structer of the slot as well as the ASCII art representing a lever.
+ * @brief Gives a key back, so the next readKey() returns it again.
  *
+ * @param key Key to give back.
  */
-void printFrame() {
+void unreadKey(int key) {
 
-	clear();
+	if (inputScript.active) inputScript.pushedBack = key;
+	else ungetch(key);
+}
 
-	banner();
+/**
+ * @brief Waits for a key to be pressed in order to continue. The wait is done by the program itself (it used to start a shell to run "pause", which took a few miliseconds every time).
+ *
+ * @param timeoutMs Optional parameter. After this many miliseconds the game continues by itself, even if no key was pressed. -1 (default) waits until a key is pressed.
+ */
+void waitForKey(int timeoutMs = -1) {
+
+	const char* prompt = timeoutMs < 0 ? "Press any key to continue . . . " : "Continuing by itself, or press any key . . . ";
+
+	renderText(LINES - 2, 1, prompt);
+	renderCursor(true, LINES - 2, 1 + (int)strlen(prompt)); // Move cursor to the bottom left of the screen, after the message
+	renderPresent();
+	readKey(timeoutMs);
+	renderCursor(false);
+}
+
+/**
+ * @brief Displays text right in the middle of the screen.
+ *
+ * @param message1 Message to be displayed.
+ * @param message2 Optional parameter. This message will be displayed right below the first one.
+ */
+void displayCentralMessage(const char* message1, const char* message2 = NULL) {
+
+	int center1 = strlen(message1) / 2; // Calculates the center of the message
+
+	newScreen();
+
+	renderText((LINES / 2), (COLS / 2) - center1, message1);
+
+	if (message2 != NULL) { // If there are two messages to be displayed, do the same as for the first message but on the line below.
+		int center2 = strlen(message2) / 2;
+		renderText((LINES / 2 + 1), (COLS / 2) - center2, message2);
+	}
+
+	renderPresent();
+}
+
+/**
+ * @brief Fast pseudo-random number generator (xoshiro256**). Its 256 bits of state are filled from the seed with SplitMix64, so any seed (even 0) is fine.
+ *
+ */
+struct Xoshiro256 {
+	unsigned long long state[4];
+
+	explicit Xoshiro256(unsigned long long seed = 0) {
+		for (unsigned long long& word : state) { // SplitMix64
+			seed += 0x9E3779B97F4A7C15ULL;
+			unsigned long long z = seed;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	static unsigned long long rotl(unsigned long long x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	unsigned long long next() {
+		unsigned long long result = rotl(state[1] * 5, 7) * 9;
+		unsigned long long t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+
+		return result;
+	}
+
+	unsigned int next32() {
+		return (unsigned int)(next() >> 32); // The upper bits are the best ones
+	}
+};
+
+/**
+ * @brief Counter-based random number generator (Philox4x32-10). Each number is worked out from the seed and its position only, so it can jump to any position of the stream in O(1) with discard().
+ *
+ */
+struct Philox4x32 {
+	unsigned int key[2];        // The seed
+	unsigned long long block;   // Counter of the next block of 4 numbers to generate
+	unsigned int output[4];     // Last block generated
+	unsigned int index;         // Next number of the output to return. 4 when a new block is needed
+
+	explicit Philox4x32(unsigned long long seed = 0) {
+		key[0] = (unsigned int)seed;
+		key[1] = (unsigned int)(seed >> 32);
+		block = 0;
+		index = 4;
+	}
+
+	void generate() {
+		unsigned int c[4] = { (unsigned int)block, (unsigned int)(block >> 32), 0, 0 };
+		unsigned int k[2] = { key[0], key[1] };
 
-	for (unsigned short int i = 8; i < 19; i++) {
-		if (i == 8 || i == 18) { // If it's the top or bottom
-			mvaddstr(i, 33, "#################################");
+		for (unsigned short int round = 0; round < 10; round++) {
+			unsigned long long product0 = 0xD2511F53ULL * c[0];
+			unsigned long long product1 = 0xCD9E8D57ULL * c[2];
+
+			c[0] = (unsigned int)(product1 >> 32) ^ c[1] ^ k[0];
+			c[1] = (unsigned int)product1;
+			c[2] = (unsigned int)(product0 >> 32) ^ c[3] ^ k[1];
+			c[3] = (unsigned int)product0;
+
+			k[0] += 0x9E3779B9;
+			k[1] += 0xBB67AE85;
 		}
-		else if (i == 13) { // If it's the middle
-			mvaddstr(i, 33, "#==>|                       |<==#");
+		for (unsigned short int i = 0; i < 4; i++) {
+			output[i] = c[i];
 		}
-		else {
-			mvaddstr(i, 33, "#                               #");
+		block++;
+		index = 0;
+	}
+
+	void discard(unsigned long long count) {
+		unsigned long long position = block * 4 - 4 + index + count; // Nr of numbers already used, plus the ones to skip
+
+		block = position / 4;
+		index = 4;
+		if (position % 4 != 0) { // Landed in the middle of a block
+			generate();
+			index = position % 4;
+		}
+	}
+
+	unsigned int next32() {
+		if (index == 4) generate();
+
+		return output[index++];
+	}
+};
+
+/**
+ * @brief Every random number generator that can be chosen at startup with "--rng".
+ *
+ */
+enum RngEngine : unsigned char { XOSHIRO, PHILOX, RNG_ENGINES };
+
+const char* const rngNames[RNG_ENGINES] = { "xoshiro", "philox" }; // Names of the generators, as they are used in the command line
+
+RngEngine rngEngine = XOSHIRO; // Generator chosen at startup
+Xoshiro256 xoshiroRng;         // Generator used by the game when rngEngine is XOSHIRO
+Philox4x32 philoxRng;          // Generator used by the game when rngEngine is PHILOX
+
+/**
+ * @brief Chooses the random number generator from its name in the command line.
+ *
+ * @param name Name of the generator ("xoshiro" or "philox").
+ * @return true If there's a generator with that name, which is now used by rngEngine.
+ * @return false If there isn't, rngEngine is left as it was.
+ */
+bool chooseRng(const string& name) {
+
+	for (unsigned short int engine = 0; engine < RNG_ENGINES; engine++) {
+		if (name == rngNames[engine]) {
+			rngEngine = RngEngine(engine);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Generates an unbiased random number between 0 and range - 1 (Lemire's method). It multiplies instead of using %, and only needs a division in the very rare case where the result could be biased.
+ *
+ * @param rng Random number generator to use.
+ * @param range How many different numbers can be generated.
+ * @return unsigned int Random number between 0 and range - 1.
+ */
+template <typename Engine>
+unsigned int randomBelow(Engine& rng, unsigned int range) {
+
+	unsigned long long product = (unsigned long long)rng.next32() * range;
+	unsigned int low = (unsigned int)product;
+
+	if (low < range) {
+		unsigned int threshold = (0u - range) % range; // Numbers below this would make some results more likely than others
+		while (low < threshold) {
+			product = (unsigned long long)rng.next32() * range;
+			low = (unsigned int)product;
 		}
 	}
+	return (unsigned int)(product >> 32);
+}
 
+/**
+ * @brief Generates a random fruit with the given random number generator.
+ *
+ * @param rng Random number generator to use.
+ * @return Symbol Random slot machine fruit symbol.
+ */
+template <typename Engine>
+Symbol randomSymbol(Engine& rng) {
+	return Symbol(randomBelow(rng, SYMBOLS)); // Random number between 0-12
+}
 
-	mvaddstr(9, 73, R"( ___ (@) )");
-	mvaddstr(10, 73, R"(|.-.|/ )");
-	mvaddstr(11, 73, R"(|| |/ )");
-	mvaddstr(12, 73, R"(|| /|)");
-	mvaddstr(13, 73, R"(||/||)");
-	mvaddstr(14, 73, R"(|| ||)");
-	mvaddstr(15, 73, R"(|| ||)");
-	mvaddstr(16, 73, R"('---')");
+/**
+ * @brief Generates a random fruit from a pre-defined list, with the generator chosen at startup.
+ *
+ * @return Symbol Random slot machine fruit symbol.
+ */
+Symbol slotSymbols() {
 
-	mvaddstr(17, 68, "Press [ENTER] to");
-	mvaddstr(18, 68, "lock each column");
+	if (rngEngine == PHILOX) return randomSymbol(philoxRng);
 
-	refresh();
+	return randomSymbol(xoshiroRng);
 }
 
 /**
- * @brief Waits for a key to be pressed in order to continue.
+ * @brief Picks where a reel stops, with the generator chosen at startup. Every position of the strip is equally likely.
  *
+ * @return int Position of the strip that stops on the middle line.
  */
-void waitForKey() {
+int randomStop() {
+
+	if (rngEngine == PHILOX) return (int)randomBelow(philoxRng, stripLength);
 
-	curs_set(1);
-	move(LINES - 2, 1);// Move cursor to the bottom left of the screen
-	refresh();
-	system("pause");
-	curs_set(0);
+	return (int)randomBelow(xoshiroRng, stripLength);
 }
 
 /**
- * @brief Displays text right in the middle of the screen.
+ * @brief Fills a column with the 7 symbols of a reel strip that are seen through the slot.
  *
- * @param message1 Message to be displayed.
- * @param message2 Optional parameter. This message will be displayed right below the first one.
+ * @param reel Reel of the column (0-2).
+ * @param offset Position of the strip on the top line.
+ * @param column Column to be filled.
+ */
+void stripWindow(int reel, int offset, Column& column) {
+
+	for (unsigned short int i = 0; i < 7; i++) {
+		column[i] = reelStrips[reel][(offset + i) % stripLength];
+	}
+}
+
+/**
+ * @brief Turns the reels that are still rotating by one symbol per frame period. No random numbers are needed, the strip just moves. The stopping reel doesn't turn past its stop.
+ *
+ * @param spin State of the spin, with the position of the reels.
+ * @param firstReel First reel that is still rotating, the ones before it are locked.
+ * @param periods Nr of frame periods since the last frame (more than 1 if frames were skipped), so the reels turn at the same speed however long a frame takes to draw.
+ */
+void advanceReels(SpinState& spin, int firstReel, long long periods) {
+
+	for (int reel = firstReel; reel < 3; reel++) {
+		long long steps = periods % stripLength;
+
+		if (reel == spin.stopping) steps = min(periods, (long long)(spin.offsets[reel] - spin.stop + stripLength) % stripLength); // Symbols left until the stop
+
+		spin.offsets[reel] = (int)((spin.offsets[reel] + stripLength - steps) % stripLength); // The symbols move down
+	}
+}
+
+/**
+ * @brief Starts the frame clock from now. Called when the columns start rotating, so the time before (e.g. waiting for a key) doesn't count as a frame.
+ *
+ */
+void startFrameClock() {
+
+	frameClock.deadline = chrono::steady_clock::now();
+	frameClock.frameStart = frameClock.deadline;
+	frameClock.running = true;
+}
+
+/**
+ * @brief Controls the speed of the rotating columns. Waits until the deadline of the current frame, which is always one period after the deadline of the previous one. If the rendering fell behind and the deadline already passed, the frames that were missed are skipped instead of drawn late.
+ * While it waits, it listens to the keyboard. If a key is pressed, the frame ends straight away and the key is put back so the game sees it and locks the column without waiting for the rest of the frame.
+ *
+ * @return long long Returns the nr of periods since the previous frame, i.e. how many symbols the reels turn: 1, plus the frames that were skipped. Always 1 while an input script is played, whose keys are timed in frames, so a replay draws the same frames on any machine.
+ */
+long long colsRotating() {
+
+	if (!frameClock.running) startFrameClock();
+
+	chrono::steady_clock::duration period = chrono::microseconds(1000000 / framesPerSecond);
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+	frameClock.deadline += period;
+
+	long long periods = 1;
+
+	if (now > frameClock.deadline) { // Behind schedule, skip to the next deadline that can still be met
+		long long missed = (now - frameClock.deadline) / period + 1;
+
+		frameClock.skipped += missed;
+		frameClock.deadline += missed * period;
+		periods += missed;
+	}
+
+	while ((now = chrono::steady_clock::now()) < frameClock.deadline) {
+		int remaining = (int)chrono::duration_cast<chrono::milliseconds>(frameClock.deadline - now + chrono::microseconds(999)).count(); // Rounded up, so it doesn't wake up too early
+		int key = readKey(remaining);
+
+		if (key != ERR) {
+			unreadKey(key);
+			now = chrono::steady_clock::now();
+			frameClock.deadline = now; // The next frames are scheduled from here
+			break;
+		}
+	}
+
+	long long bucket = chrono::duration_cast<chrono::microseconds>(now - frameClock.frameStart).count() / 100; // 0.1ms buckets
+
+	frameClock.frameTimes[min(bucket, (long long)frameTimeBuckets - 1)]++;
+	frameClock.frames++;
+	frameClock.frameStart = now;
+
+	return inputScript.active ? 1 : periods;
+}
+
+/**
+ * @brief Works out a percentile of the frame times from the histogram of the frame clock.
+ *
+ * @param percentile Percentile to work out, between 0 and 1 (e.g. 0.99).
+ * @return double Returns the frame time in milliseconds.
+ */
+double frameTimePercentile(double percentile) {
+
+	unsigned long long target = (unsigned long long)ceil(frameClock.frames * percentile);
+	unsigned long long seen = 0;
+
+	for (int bucket = 0; bucket < frameTimeBuckets; bucket++) {
+		seen += frameClock.frameTimes[bucket];
+		if (seen >= target && seen > 0) return bucket / 10.0;
+	}
+	return 0;
+}
+
+#ifdef ANSI_REELS
+/**
+ * @brief Writes a whole buffer to the terminal. write() can send only part of it (or be interrupted by a signal before sending anything), so it's called again with the rest until everything is sent.
+ *
+ * @param buffer Bytes to write.
+ * @param length Number of bytes to write.
+ * @return true If every byte was written.
+ * @return false If write() failed, so the terminal has an unknown part of the buffer.
+ */
+bool writeAll(const char* buffer, int length) {
+
+	while (length > 0) {
+		ssize_t written = write(ansiReels.output, buffer, length);
+
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) return false;
+
+		ansiReels.writes++;
+		ansiReels.bytes += written;
+		buffer += written;
+		length -= (int)written;
+	}
+	return true;
+}
+
+/**
+ * @brief Displays a frame of the slot machine columns by writing the cells that changed to the terminal in one buffer of ANSI escape codes (moving the cursor to each cell and printing its 7 characters), with a single write().
+ * Once the buffer is on the terminal, the cells are also written to stdscr and to curses' copy of the terminal (curscr), so curses knows they are there and the next refresh doesn't send them again or erase them.
+ *
+ * @param frame Symbols of the 3 columns to display.
+ * @return true If the frame was written.
+ * @return false If write() failed. The ANSI path is turned off, and curses is told to repaint the whole screen, because nobody knows what got to the terminal.
+ */
+bool drawReelsAnsi(const Reels& frame) {
+
+	char buffer[512]; // 21 cells of 15 bytes at most and the final cursor move
+	int length = 0;
+	int y, x;
+
+	getyx(curscr, y, x); // Where curses thinks the cursor is
+
+	for (unsigned short int i = 0; i < 7; i++) { // Line by line, so cells next to each other can be sent without moving the cursor
+		bool follows = false; // True if the cursor is right after the cell on the left
+
+		for (unsigned short int col = 0; col < 3; col++) {
+			if (!reelArea.valid || reelArea.shown[col][i] != frame[col][i]) { // If the cell changed, send it
+				const char* cell = symbolCells[frame[col][i]];
+
+				if (follows) length += snprintf(buffer + length, sizeof(buffer) - length, " %s", cell); // The blank between the columns is 1 byte, moving the cursor is 8
+				else length += snprintf(buffer + length, sizeof(buffer) - length, "\x1b[%d;%dH%s", i + 11, 39 + col * 8, cell); // ANSI lines and columns start at 1
+				follows = true;
+			}
+			else follows = false;
+		}
+	}
+	length += snprintf(buffer + length, sizeof(buffer) - length, "\x1b[%d;%dH", y + 1, x + 1); // The cursor goes back where curses left it
+
+	if (!writeAll(buffer, length)) {
+		ansiReels.enabled = false;
+		reelArea.valid = false;
+		clearok(curscr, TRUE); // The next refresh repaints everything
+		return false;
+	}
+
+	for (unsigned short int col = 0; col < 3; col++) {
+		for (unsigned short int i = 0; i < 7; i++) {
+			if (!reelArea.valid || reelArea.shown[col][i] != frame[col][i]) {
+				mvaddstr(i + 10, 38 + col * 8, symbolCells[frame[col][i]]);
+				mvwaddstr(curscr, i + 10, 38 + col * 8, symbolCells[frame[col][i]]);
+
+				reelArea.cells++;
+			}
+		}
+	}
+	wmove(curscr, y, x);
+
+	reelArea.bytes += length;
+	reelArea.shown = frame;
+	reelArea.valid = true;
+	reelArea.frames++;
+	return true;
+}
+#endif
+
+/**
+ * @brief Displays a frame of the slot machine columns. Only the cells that are different from the ones already on the screen are sent, and the screen is refreshed once.
+ *
+ * @param frame Symbols of the 3 columns to display.
+ */
+void drawReels(const Reels& frame) {
+
+#ifdef ANSI_REELS
+	if (ansiReels.enabled && renderer.backend == CURSES_RENDERER && drawReelsAnsi(frame)) return; // If the write fails, this frame (and the next ones) go through curses
+#endif
+
+	for (unsigned short int col = 0; col < 3; col++) {
+		for (unsigned short int i = 0; i < 7; i++) {
+			if (!reelArea.valid || reelArea.shown[col][i] != frame[col][i]) { // If the cell changed, send it
+				renderText(i + 10, 38 + col * 8, symbolCells[frame[col][i]]);
+
+				reelArea.cells++;
+				reelArea.bytes += cellBytes;
+			}
+		}
+	}
+	reelArea.shown = frame;
+	reelArea.valid = true;
+	reelArea.estimated = true;
+	reelArea.frames++;
+
+	renderPresent();
+}
+
+/**
+ * @brief Result of one spin: its prize and what it adds to each counter of the stats.
+ *
+ */
+struct Payout {
+	unsigned short int points; // Amount of points of the spin
+	Prize prize;               // Prize of the spin
+	unsigned char jackpots;    // 1 if it's a Jackpot
+	unsigned char twoSymbols;  // 1 if it has 2 equal symbols (but not 3)
+	unsigned char diamonds;    // Nr of DIAMONDs counted
+};
+
+/**
+ * @brief Reference implementation of the rules of the game, exactly as they have always been written. Only used to check the payout table when the program is compiled.
+ *
+ * @param first Symbol in the middle line of the first column.
+ * @param second Symbol in the middle line of the second column.
+ * @param third Symbol in the middle line of the third column.
+ * @return Payout Returns the result of the spin.
+ */
+constexpr Payout referencePayout(Symbol first, Symbol second, Symbol third) {
+
+	/*
+	50pts for each DIAMOND
+
+	DIAMOND DIAMOND DIAMOND - 1000pts
+	BANANA BANANA BANANA		- 150pts
+	DIAMOND DIAMOND BANANA	- 110pts
+	BANANA BANANA DIAMOND	- 60pts
+	BANANA APPLES DIAMOND	- 50pts
+	BANANA BANANA APPLES		- 10pts
+	BANANA APPLES ORANGE		- 0pts
+	 */
+
+	Payout payout = {};
+
+	if ((first == second) && (first == third)) {
+
+		payout.jackpots++;
+
+		if (first == DIAMOND) {// DIAMOND DIAMOND DIAMOND - 1000pts
+
+			payout.diamonds += 3;
+
+			payout.points += 1000;
+		}
+		else {// BANANA BANANA BANANA - 150pts
+			payout.points += 150;
+		}
+	}
+	else if ((first == second) || (first == third) || (second == third)) {// BANANA BANANA APPLES - 10pts
+
+		payout.twoSymbols++;
+		payout.points += 10;
+
+		if (first == DIAMOND) {// DIAMOND BANANA BANANA - 60pts
+			payout.diamonds++;
+			payout.points += 50;
+			if (second == DIAMOND || third == DIAMOND) {// DIAMOND DIAMOND BANANA - 110pts
+				payout.diamonds++;
+				payout.points += 50;
+			}
+		}
+		else if (second == DIAMOND) {// BANANA DIAMOND BANANA - 60pts
+			payout.diamonds++;
+			payout.points += 50;
+			if (third == DIAMOND) {// BANANA DIAMOND DIAMOND - 110pts
+				payout.diamonds++;
+				payout.points += 50;
+			}
+		}
+		else if (third == DIAMOND) {// BANANA BANANA DIAMOND - 60pts
+			payout.diamonds++;
+			payout.points += 50;
+		}
+	}
+	else if (first == DIAMOND || second == DIAMOND || third == DIAMOND) {// BANANA APPLES DIAMOND - 50pts
+		payout.diamonds++;
+		payout.points += 50;
+	}
+	payout.prize = prizeOf(payout.points);
+	return payout;
+}
+
+/**
+ * @brief Works out the result of a spin from how many symbols match and how many DIAMONDs there are, without the if/else chain. This is what the payout table is generated from.
+ *
+ * @param first Symbol in the middle line of the first column.
+ * @param second Symbol in the middle line of the second column.
+ * @param third Symbol in the middle line of the third column.
+ * @return Payout Returns the result of the spin.
  */
-void displayCentralMessage(const char* message1, const char* message2 = NULL) {
+constexpr Payout generatePayout(Symbol first, Symbol second, Symbol third) {
 
-	string str1 = message1;
-	int center1 = str1.length() / 2; // Calculates the center of the message
+	bool jackpot = (first == second) && (second == third);
+	bool match = (first == second) || (first == third) || (second == third);
+	unsigned char diamonds = (first == DIAMOND) + (second == DIAMOND) + (third == DIAMOND);
 
-	clear();
-	banner();
+	Payout payout = {};
 
-	mvaddstr((LINES / 2), (COLS / 2) - center1, message1);
+	if (jackpot) payout.prize = (first == DIAMOND) ? DIAMOND_JACKPOT : JACKPOT;
+	else payout.prize = prizeOf(prizePoints[TWO_SYMBOLS] * match + prizePoints[ONE_DIAMOND] * diamonds);
 
-	if (message2 != NULL) { // If there are two messages to be displayed, do the same as for the first message but on the line below.
-		string str2 = message2;
-		int center2 = str2.length() / 2;
-		mvaddstr((LINES / 2 + 1), (COLS / 2) - center2, message2);
-	}
+	payout.points = prizePoints[payout.prize];
+	payout.jackpots = jackpot;
+	payout.twoSymbols = match && !jackpot;
+	payout.diamonds = diamonds;
 
-	refresh();
+	return payout;
 }
 
 /**
- * @brief Generates a random fruit from a pre-defined list.
+ * @brief Lookup table with the result of every possible spin, generated when the program is compiled.
  *
- * @return string Random slot machine fruit symbol.
  */
-string slotSymbols() {
-
-	string symbols[13] = { "APPLES", "BANANA", "CHERRY", "LEMONS", "GRAPES", "ORANGE", "DIAMOND", "MELONS", "APRICOT", "KIWIS", "MANGO", "PEACH", "PEARS" };
-
-	return symbols[rand() % 13]; // Random number between 0-12
-}
+struct PayoutTable {
+	Payout payouts[SYMBOLS * SYMBOLS * SYMBOLS];
+};
 
 /**
- * @brief Controls the speed of the rotating columns.
+ * @brief Position of a spin in the payout table.
  *
+ * @param first Symbol in the middle line of the first column.
+ * @param second Symbol in the middle line of the second column.
+ * @param third Symbol in the middle line of the third column.
+ * @return int Returns the position of the spin in the table.
  */
-void colsRotating() {
-	this_thread::sleep_for(chrono::milliseconds(speed));
+constexpr int payoutIndex(Symbol first, Symbol second, Symbol third) {
+	return (first * SYMBOLS + second) * SYMBOLS + third;
 }
 
 /**
- * @brief Clears specific columns of the slot machine.
+ * @brief Generates the payout table.
  *
- * @param firstColLocked In case this parameter is true, the function will only clear the second and third columns.
- * @param secondColLocked In case this parameter is true, the function will only clear the third column.
+ * @return PayoutTable Returns the result of every possible spin.
  */
-void clearSlot(bool firstColLocked = false, bool secondColLocked = false) {
+constexpr PayoutTable buildPayoutTable() {
 
-	if (!firstColLocked && !secondColLocked) { // If both the first and second columns haven't been locked yet, clear all columns.
-		for (unsigned short int i = 10; i < 17; i++) {
+	PayoutTable table = {};
 
-			mvaddstr(i, 38, "       ");
-			mvaddstr(i, 46, "       ");
-			mvaddstr(i, 54, "       ");
+	for (int first = 0; first < SYMBOLS; first++) {
+		for (int second = 0; second < SYMBOLS; second++) {
+			for (int third = 0; third < SYMBOLS; third++) {
+				table.payouts[payoutIndex(Symbol(first), Symbol(second), Symbol(third))] = generatePayout(Symbol(first), Symbol(second), Symbol(third));
+			}
 		}
 	}
-	else if (firstColLocked && !secondColLocked) { // If the first has been locked, clear only the second and third columns.
-		for (unsigned short int i = 10; i < 17; i++) {
+	return table;
+}
 
-			mvaddstr(i, 46, "       ");
-			mvaddstr(i, 54, "       ");
-		}
-	}
-	else if (firstColLocked && secondColLocked) { // If both the first and second columns have been locked, clear only the third column.
-		for (unsigned short int i = 10; i < 17; i++) {
+constexpr PayoutTable payoutTable = buildPayoutTable(); // Result of every possible spin, so scoring a spin is just one lookup
+
+/**
+ * @brief Checks every entry of the payout table against the reference implementation of the rules.
+ *
+ * @return bool Returns true if the whole table matches the rules.
+ */
+constexpr bool payoutTableMatchesRules() {
+
+	for (int first = 0; first < SYMBOLS; first++) {
+		for (int second = 0; second < SYMBOLS; second++) {
+			for (int third = 0; third < SYMBOLS; third++) {
+				Payout generated = payoutTable.payouts[payoutIndex(Symbol(first), Symbol(second), Symbol(third))];
+				Payout reference = referencePayout(Symbol(first), Symbol(second), Symbol(third));
 
-			mvaddstr(i, 54, "       ");
+				if (generated.points != reference.points || generated.prize != reference.prize || generated.jackpots != reference.jackpots || generated.twoSymbols != reference.twoSymbols || generated.diamonds != reference.diamonds) return false;
+			}
 		}
 	}
-	refresh();
+	return true;
 }
 
+static_assert(payoutTableMatchesRules(), "The payout table doesn't match the rules of the game");
+
 /**
- * @brief Based on the result of the slot machine, updates the user's credits according to the prize.
+ * @brief Applies the rules of the game to the three symbols in the middle line of the slot and counts the result. It doesn't print anything, so it can be used by the game itself as well as by the headless spin engine.
+ * The rules are all in the payout table, so this is just one lookup.
  *
- * @param firstCol Vector of strings containing all the symbols of the first column.
- * @param secondCol Vector of strings containing all the symbols of the second column.
- * @param thirdCol Vector of strings containing all the symbols of the third column.
+ * @param first Symbol in the middle line of the first column.
+ * @param second Symbol in the middle line of the second column.
+ * @param third Symbol in the middle line of the third column.
+ * @param tally Stats where the occurrences of Jackpots, 2 Symbols, Diamonds and the Total of games are counted.
  * @return int Returns the amount of points the user got.
  */
-int updateCredits(vector<string> firstCol, vector<string> secondCol, vector<string> thirdCol) {
-
-	/*
-	50pts for each DIAMOND
-
-	DIAMOND DIAMOND DIAMOND - 1000pts
-	BANANA BANANA BANANA		- 150pts
-	DIAMOND DIAMOND BANANA	- 110pts
-	BANANA BANANA DIAMOND	- 60pts
-	BANANA APPLES DIAMOND	- 50pts
-	BANANA BANANA APPLES		- 10pts
-	BANANA APPLES ORANGE		- 0pts
-	 */
+int scoreSpin(Symbol first, Symbol second, Symbol third, Stats& tally) {
 
-	int points = 0;
+	const Payout& payout = payoutTable.payouts[payoutIndex(first, second, third)];
 
-	if ((firstCol[3] == secondCol[3]) && (firstCol[3] == thirdCol[3])) {
+	tally.jackpots += payout.jackpots;
+	tally.twoSymbols += payout.twoSymbols;
+	tally.diamonds += payout.diamonds;
+	tally.tiers[payout.prize]++;
+	tally.total++;
 
-		stats["Jackpots"]++;
+	return payout.points;
+}
 
-		if (firstCol[3] == "DIAMOND") {// DIAMOND DIAMOND DIAMOND - 1000pts
+/**
+ * @brief Based on the result of the slot machine, updates the user's credits according to the prize.
+ *
+ * @param reels The 3 columns of the slot with all of their symbols.
+ * @return int Returns the amount of points the user got.
+ */
+int updateCredits(const Reels& reels) {
 
-			stats["Diamonds"] += 3;
+	return scoreSpin(reels[0][3], reels[1][3], reels[2][3], stats); // Only the middle line of the slot counts for the prize
+}
 
-			points += 1000;
-		}
-		else {// BANANA BANANA BANANA - 150pts
-			points += 150;
-		}
-	}
-	else if ((firstCol[3] == secondCol[3]) || (firstCol[3] == thirdCol[3]) || (secondCol[3] == thirdCol[3])) {// BANANA BANANA APPLES - 10pts
+/**
+ * @brief Displays one frame of the rotating columns. The caller turns the reels afterwards with advanceReels(), by as many symbols as frame periods went by.
+ *
+ * @param spin State of the spin, with the position of the reels and the symbols of the locked columns.
+ * @param firstReel First reel that is still rotating, the ones before it are locked.
+ */
+void drawRotCols(SpinState& spin, int firstReel = 0) {
 
-		stats["2Symbols"]++;
-		points += 10;
+	Reels frame;
 
-		if (firstCol[3] == "DIAMOND") {// DIAMOND BANANA BANANA - 60pts
-			stats["Diamonds"]++;
-			points += 50;
-			if (secondCol[3] == "DIAMOND" || thirdCol[3] == "DIAMOND") {// DIAMOND DIAMOND BANANA - 110pts
-				stats["Diamonds"]++;
-				points += 50;
-			}
-		}
-		else if (secondCol[3] == "DIAMOND") {// BANANA DIAMOND BANANA - 60pts
-			stats["Diamonds"]++;
-			points += 50;
-			if (thirdCol[3] == "DIAMOND") {// BANANA DIAMOND DIAMOND - 110pts
-				stats["Diamonds"]++;
-				points += 50;
-			}
-		}
-		else if (thirdCol[3] == "DIAMOND") {// BANANA BANANA DIAMOND - 60pts
-			stats["Diamonds"]++;
-			points += 50;
-		}
+	for (int reel = 0; reel < 3; reel++) { // 3 columns with 7 lines each
+		if (reel < firstReel) frame[reel] = spin.reels[reel];
+		else stripWindow(reel, spin.offsets[reel], frame[reel]);
 	}
-	else if (firstCol[3] == "DIAMOND" || secondCol[3] == "DIAMOND" || thirdCol[3] == "DIAMOND") {// BANANA APPLES DIAMOND - 50pts
-		stats["Diamonds"]++;
-		points += 50;
-	}
-	stats["Total"]++;
-	return points;
+	drawReels(frame);
 }
 
 /**
- * @brief Displays the slot machine columns, calls colsRotating to wait the specified amount of time, then clears all columns.
+ * @brief Displays the slot machine columns and calls colsRotating to wait the specified amount of time.
  *
+ * @param spin State of the spin, with the position of the reels.
  */
-void printRotCols() {
-
-	for (unsigned short int i = 10; i < 17; i++) { // 3 columns with 7 lines each
-		mvaddstr(i, 38, slotSymbols().c_str()); // We need to convert to C string to use with mvaddstr()
-		mvaddstr(i, 46, slotSymbols().c_str());
-		mvaddstr(i, 54, slotSymbols().c_str());
-	}
-	refresh();
-
-	colsRotating();
+void printRotCols(SpinState& spin) {
 
-	clearSlot();
+	drawRotCols(spin);
 
+	advanceReels(spin, 0, colsRotating());
 }
 
 /**
  * @brief Locks the first column, i.e. the symbols in the first column don't change while the ones in the other columns are changing.
  *
- * @param firstCol Vector of strings containing all the symbols of the first column.
+ * @param spin State of the spin, with the symbols of the locked column.
  */
-void lockFirstCol(vector<string> firstCol) {
+void lockFirstCol(SpinState& spin) {
 
-	for (unsigned short int i = 10; i < 17; i++) {
-		mvaddstr(i, 38, firstCol[i - 10].c_str());
-		mvaddstr(i, 46, slotSymbols().c_str());
-		mvaddstr(i, 54, slotSymbols().c_str());
-	}
-	refresh();
-	colsRotating();
+	drawRotCols(spin, 1);
 
-	clearSlot(true);
+	advanceReels(spin, 1, colsRotating());
 }
 
 /**
  * @brief Locks the second column, i.e. the symbols in the first and second columns don't change while the ones in the third column are changing.
  *
- * @param firstCol Vector of strings containing all the symbols of the first column.
- * @param secondCol Vector of strings containing all the symbols of the second column.
+ * @param spin State of the spin, with the symbols of the locked columns.
+ */
+void lockSecondCol(SpinState& spin) {
+
+	drawRotCols(spin, 2);
+
+	advanceReels(spin, 2, colsRotating());
+}
+
+/**
+ * @brief Stops a reel. Where it stops is picked once, now, and the reel keeps turning until it gets there, so the locked column comes out of the rotation the player was watching.
+ *
+ * @param spin State of the spin, where the position and the symbols of the locked reel are kept.
+ * @param reel Reel to stop (0-2).
  */
-void lockSecondCol(vector<string> firstCol, vector<string> secondCol) {
+void lockReel(SpinState& spin, int reel) {
+
+	spin.stopping = reel;
+	spin.stop = (randomStop() + stripLength - 3) % stripLength; // The stop position is on the middle line, 3 lines below the top
+
+	while (spin.offsets[reel] != spin.stop) { // The reels after it keep rotating too
+		drawRotCols(spin, reel);
 
-	for (unsigned short int i = 10; i < 17; i++) {
-		mvaddstr(i, 38, firstCol[i - 10].c_str());
-		mvaddstr(i, 46, secondCol[i - 10].c_str());
-		mvaddstr(i, 54, slotSymbols().c_str());
+		advanceReels(spin, reel, colsRotating());
 	}
-	refresh();
-	colsRotating();
+	spin.stopping = -1;
 
-	clearSlot(true, true);
+	stripWindow(reel, spin.offsets[reel], spin.reels[reel]);
 }
 
 /**
  * @brief Locks the third column so that all of the columns are now stopped. Also, it evaluates every column to check if the user got any prize.
  *
- * @param firstCol Vector of strings containing all the symbols of the first column.
- * @param secondCol Vector of strings containing all the symbols of the second column.
- * @param thirdCol Vector of strings containing all the symbols of the third column.
+ * @param spin State of the spin, with the symbols of all the columns.
  * @return int Returns the amount of points the user got so that the points can be later evaluated and converted into prizes.
  */
-int lockThirdCol(vector<string> firstCol, vector<string> secondCol, vector<string> thirdCol) {
+int lockThirdCol(const SpinState& spin) {
 
-	for (unsigned short int i = 10; i < 17; i++) {
-		mvaddstr(i, 38, firstCol[i - 10].c_str());
-		mvaddstr(i, 46, secondCol[i - 10].c_str());
-		mvaddstr(i, 54, thirdCol[i - 10].c_str());
-	}
-	refresh();
+	drawReels(spin.reels);
 
-	return updateCredits(firstCol, secondCol, thirdCol);
+	return updateCredits(spin.reels);
 }
 
 /**
@@ -349,20 +1723,41 @@ int lockThirdCol(vector<string> firstCol, vector<string> secondCol, vector<strin
  * @param message Message to be displayed.
  */
 void displayResult(const char* message) {
-	string str = message;
-	int center = str.length() / 2;
+	int center = strlen(message) / 2;
+
+	renderText(22, (COLS / 2) - center, message);
+
+	renderPresent();
+}
+
+/**
+ * @brief Adds the amount of points the user got to their credits and stats. If the amount isn't any of the prizes, something went wrong, so the price of the game is given back instead.
+ *
+ * @param result Amount of points the user got.
+ * @return Prize Returns the prize the user got, or PRIZES if something went wrong.
+ */
+Prize payPrize(int result) {
 
-	mvaddstr(22, (COLS / 2) - center, message);
+	Prize prize = prizeOf(result); // The payouts of the prizes are in the prizePoints table
 
-	refresh();
+	if (prize != PRIZES) {
+		credit += result;
+		stats.earned += result;
+	}
+	else {
+		credit += price;
+		stats.spent -= price;
+	}
+	return prize;
 }
 
 /**
  * @brief Adds the amount of points the user got to their credits and displays a message accordingly to their result.
  *
  * @param result Amount of points the user got.
+ * @param timeoutMs Optional parameter. Miliseconds the result stays on the screen before the game continues by itself. -1 (default) waits for a key.
  */
-void evalResult(int result) {
+void evalResult(int result, int timeoutMs = -1) {
 
 	/*
 	50pts for each DIAMOND
@@ -376,135 +1771,60 @@ void evalResult(int result) {
 	BANANA APPLES ORANGE		- 0pts
 	 */
 
+	Prize prize = payPrize(result);
 
-	switch (result)
-	{
-	case 0: displayResult("Bad luck... Maybe next time!");
-
-		banner();
-		waitForKey();
-		break;
-
-	case 10: displayResult("Congrats!! You got two symbols!");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	case 50: displayResult("At least you got a DIAMOND!");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	case 60: displayResult("Congrats!! You got two symbols AND a DIAMOND!");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	case 110: displayResult("Congrats!! You got two symbols and they are both a DIAMOND!");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	case 150: displayResult("=====>   JACKPOT!!!   <=====");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	case 1000: displayResult("=====>   OMG A DIAMOND JACKPOT!!!   <=====");
-
-		credit += result;
-		stats["Earned"] += result;
-
-		banner();
-		waitForKey();
-		break;
-
-	default:
-		mvaddstr(20, 30, "Something went wrong with the Slot Machine...");
-		mvaddstr(21, 30, "        You didn't lose credits.");
-
-		credit += price;
-		stats["Spent"] -= price;
-
-
-		banner();
-		waitForKey();
-		break;
+	if (prize != PRIZES) {
+		displayResult(prizeMessages[prize]);
+	}
+	else {
+		renderText(20, 30, "Something went wrong with the Slot Machine...");
+		renderText(21, 30, "        You didn't lose credits.");
 	}
+
+	banner();
+	waitForKey(timeoutMs);
 }
 
 /**
  * @brief One of the core functions of this program. It's responsible for calling the function to print the slot frame, for calling the function that makes the columns rotate, to catch the user input to stop each column and to call the function that checks if user get a prize or not.
  *
+ * @param spin State of the spin, created once per session. It's reused for every spin so the spin doesn't allocate anything.
  * @return int Returns the amount of points the user got so that the points can be later evaluated and converted into prizes.
  */
-int slotMachine() {
-
-	nodelay(stdscr, TRUE);  // Causes getch to be a non-blocking call. If no input is ready, getch returns ERR. If disabled (bf is FALSE), getch waits until a key is pressed.
+int slotMachine(SpinState& spin) {
 
 	int key;
 
 	printFrame();
+	startFrameClock();
 
 	while (true) {
-		if ((key = getch()) == ERR) { // If no key is pressed then continue showing the rotating columns
+		if ((key = readKey(0)) == ERR) { // If no key is pressed then continue showing the rotating columns
 
-			printRotCols();
+			printRotCols(spin);
 		}
 		else { // When key is pressed, lock first column
 
-			vector<string> firstCol;
-
-			for (unsigned short int i = 0; i < 7; i++) {
-				firstCol.push_back(slotSymbols());
-			}
+			lockReel(spin, 0);
 
 			while (true) {
-				if ((key = getch()) == ERR) {
+				if ((key = readKey(0)) == ERR) {
 
-					lockFirstCol(firstCol);
+					lockFirstCol(spin);
 				}
 				else { // When key is pressed, lock second column*/
 
-					vector<string> secondCol;
-
-					for (unsigned short int i = 0; i < 7; i++) {
-						secondCol.push_back(slotSymbols());
-					}
+					lockReel(spin, 1);
 
 					while (true) {
-						if ((key = getch()) == ERR) {
+						if ((key = readKey(0)) == ERR) {
 
-							lockSecondCol(firstCol, secondCol);
+							lockSecondCol(spin);
 						}
 						else { // When key is pressed, lock third column*/
-							vector<string> thirdCol;
+							lockReel(spin, 2);
 
-							for (unsigned short int i = 0; i < 7; i++) {
-								thirdCol.push_back(slotSymbols());
-							}
-
-							return lockThirdCol(firstCol, secondCol, thirdCol);
+							return lockThirdCol(spin);
 						}
 					}
 				}
@@ -525,8 +1845,7 @@ void loopGame();
  */
 void printPrizes() {
 
-	clear();
-	banner();
+	newScreen();
 
 	/*
 	50pts for each DIAMOND
@@ -539,23 +1858,24 @@ void printPrizes() {
 	BANANA BANANA APPLES		- 10pts
 	BANANA APPLES ORANGE		- 0pts
 	 */
-	mvaddstr(9, 30, "Prizes:");
-	mvaddstr(12, 35, "Each DIAMOND            - 50 credits");
-	mvaddstr(14, 35, "DIAMOND DIAMOND DIAMOND - 1000 credits");
-	mvaddstr(15, 35, "BANANA BANANA BANANA    - 150 credits");
-	mvaddstr(16, 35, "DIAMOND DIAMOND BANANA  - 110 credits");
-	mvaddstr(17, 35, "BANANA BANANA DIAMOND   - 60 credits");
-	mvaddstr(18, 35, "BANANA APPLES DIAMOND   - 50 credits");
-	mvaddstr(19, 35, "BANANA BANANA APPLES    - 10 credits");
-	mvaddstr(20, 35, "BANANA APPLES ORANGE    - 0 credits");
+	renderText(9, 30, "Prizes:");
+	renderText(12, 35, "Each DIAMOND            - 50 credits");
+	renderText(14, 35, "DIAMOND DIAMOND DIAMOND - 1000 credits");
+	renderText(15, 35, "BANANA BANANA BANANA    - 150 credits");
+	renderText(16, 35, "DIAMOND DIAMOND BANANA  - 110 credits");
+	renderText(17, 35, "BANANA BANANA DIAMOND   - 60 credits");
+	renderText(18, 35, "BANANA APPLES DIAMOND   - 50 credits");
+	renderText(19, 35, "BANANA BANANA APPLES    - 10 credits");
+	renderText(20, 35, "BANANA APPLES ORANGE    - 0 credits");
 
 
 	char option; // 'r' to return to the previous menu
 	do {
 
-		mvaddstr(22, 30, "Press 'r' to return to the previous menu.");
+		renderText(22, 30, "Press 'r' to return to the previous menu.");
+		renderPresent();
 
-		option = getch();
+		option = readKey();
 
 		if (option == 'r') printRules();
 
@@ -569,24 +1889,24 @@ void printPrizes() {
  */
 void printRules() {
 
-	clear();
-	banner();
+	newScreen();
 
-	mvaddstr(9, 20, "Rules:");
-	mvprintw(12, 25, "# You start with 100 credits and each game costs you %d credits.", price);
-	mvaddstr(14, 25, "# You can play the Normal Mode, the Fast Mode and the Ultra-Fast Mode:");
-	mvaddstr(16, 30, "* Normal Mode(1) requires full user interaction like a normal slot machine.");
-	mvaddstr(18, 30, "* Fast Mode(2) requires less user interaction but you can still control");
-	mvaddstr(19, 33, "when each column stops.");
-	mvaddstr(21, 30, "* Ultra-Fast Mode(3) requires no user interaction and the game will run until");
-	mvprintw(22, 33, "you have less than %d credits.", price);
+	renderText(9, 20, "Rules:");
+	renderPrint(12, 25, "# You start with 100 credits and each game costs you %d credits.", price);
+	renderText(14, 25, "# You can play the Normal Mode, the Fast Mode and the Ultra-Fast Mode:");
+	renderText(16, 30, "* Normal Mode(1) requires full user interaction like a normal slot machine.");
+	renderText(18, 30, "* Fast Mode(2) requires less user interaction but you can still control");
+	renderText(19, 33, "when each column stops.");
+	renderText(21, 30, "* Ultra-Fast Mode(3) requires no user interaction and the game will run until");
+	renderPrint(22, 33, "you have less than %d credits.", price);
 
 	char option; // 'p' for prizes or 'r' to return to the previous menu
 	do {
 
-		mvaddstr(24, 20, "Press 'p' to see the prizes or 'r' to return to the previous menu.");
+		renderText(24, 20, "Press 'p' to see the prizes or 'r' to return to the previous menu.");
+		renderPresent();
 
-		option = getch();
+		option = readKey();
 
 		if (option == 'p') printPrizes();
 		else if (option == 'r') return;
@@ -600,12 +1920,11 @@ void printRules() {
  */
 void cashOut() {
 
-	clear();
-	banner();
+	newScreen();
 
 	if (credit > 0) {
-		mvprintw(LINES / 2, 50, "Cashing out %d credits!", credit);
-		mvaddstr((LINES / 2) + 1, 53, "Congratulations!!");
+		renderPrint(LINES / 2, 50, "Cashing out %d credits!", credit);
+		renderText((LINES / 2) + 1, 53, "Congratulations!!");
 
 		waitForKey();
 	}
@@ -633,30 +1952,149 @@ char checkCredit() {
 }
 
 /**
- * @brief Quickly fills out the columns with symbols and check if there's any winning combination and updates the credit variable accordingly.
+ * @brief Plays one spin without touching the screen. Only the middle line of the slot decides the prize, so only those three symbols are generated.
+ *
+ * @param tally Stats where the result of the spin is counted.
+ * @return int Returns the amount of points the spin got.
+ */
+int headlessSpin(Stats& tally) {
+
+	Symbol first = slotSymbols();
+	Symbol second = slotSymbols();
+	Symbol third = slotSymbols();
+
+	return scoreSpin(first, second, third, tally);
+}
+
+/**
+ * @brief Quickly plays a game without waiting for the user and updates the credit variable accordingly.
  *
  */
 void ultraFastMode() {
 
-	vector<string> firstCol;
-	for (unsigned short int i = 0; i < 7; i++) {
-		firstCol.push_back(slotSymbols());
+	int value = headlessSpin(stats);
+
+	credit += value;
+	stats.earned += value;
+}
+
+constexpr int summaryRate = 30; // Times per second the summary of Ultra-Fast Mode is drawn
+
+/**
+ * @brief Progress of the games played by the Ultra-Fast Mode thread. The thread writes it and the screen only reads it, so the screen never touches credit or stats while the thread is playing.
+ *
+ */
+struct UltraFastProgress {
+	atomic<int> credit; // Credit after the last game played
+	atomic<long long> games; // Games played since the batch started
+	atomic<long long> started; // When the thread started playing (nanoseconds of the steady clock), so the speed doesn't count starting the thread
+	double seconds = 0; // Time the thread took to play the batch. Written before finished is set
+	bool finished = false; // Set when the thread played all the games of the batch or ran out of credit. Protected by lock
+	mutex lock; // Protects finished
+	condition_variable done; // Notified when finished is set
+};
+
+/**
+ * @brief Plays Ultra-Fast Mode games as fast as the CPU allows. Runs on its own thread, the screen is drawn by the main thread.
+ *
+ * @param games Maximum nr of games to play.
+ * @param progress Where the thread publishes the credit and the nr of games played.
+ */
+void ultraFastWorker(int games, UltraFastProgress& progress) {
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	progress.started.store(chrono::duration_cast<chrono::nanoseconds>(start.time_since_epoch()).count(), memory_order_relaxed);
+
+	for (int i = 0; i < games && credit >= price; i++) {
+		credit -= price;
+		stats.spent += price;
+
+		ultraFastMode();
+
+		progress.credit.store(credit, memory_order_relaxed);
+		progress.games.store(i + 1, memory_order_relaxed);
 	}
 
-	vector<string> secondCol;
-	for (unsigned short int i = 0; i < 7; i++) {
-		secondCol.push_back(slotSymbols());
+	progress.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	{
+		lock_guard<mutex> guard(progress.lock);
+		progress.finished = true;
 	}
+	progress.done.notify_one();
+}
 
-	vector<string> thirdCol;
-	for (unsigned short int i = 0; i < 7; i++) {
-		thirdCol.push_back(slotSymbols());
+/**
+ * @brief Draws the summary of Ultra-Fast Mode: credit, games played and how many games per second are being played.
+ *
+ * @param progress Progress published by the Ultra-Fast Mode thread.
+ * @param playedBefore Games played in the session before this batch started.
+ * @param seconds Time the thread has been playing.
+ */
+void drawUltraFastSummary(const UltraFastProgress& progress, long long playedBefore, double seconds) {
+
+	long long games = progress.games.load(memory_order_relaxed);
+
+	renderPrint(LINES / 2 - 1, 50, "Credit: %-12d", progress.credit.load(memory_order_relaxed));
+	renderPrint(LINES / 2, 50, "Games played: %-12lld", playedBefore + games);
+	renderMeasured(LINES / 2 + 1, 50, "Games per second: %-12.0f", seconds > 0 ? games / seconds : 0.0);
+	renderPresent();
+}
+
+/**
+ * @brief Plays a batch of Ultra-Fast Mode games on a separate thread while the screen shows a summary that is refreshed summaryRate times per second, so drawing never slows the games down.
+ * The screen waits on a condition variable, so it wakes up as soon as the thread is done instead of sleeping until the next refresh. The speed shown is worked out from the time the thread itself took.
+ *
+ * @param games Maximum nr of games to play. Fewer are played if the credit runs out.
+ */
+void ultraFastBatch(int games) {
+
+	UltraFastProgress progress;
+	progress.credit = credit;
+	progress.games = 0;
+	progress.started = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+
+	long long playedBefore = stats.total;
+
+	newScreen();
+
+	chrono::steady_clock::time_point deadline = chrono::steady_clock::now();
+
+	thread worker(ultraFastWorker, games, ref(progress));
+
+	while (true) {
+		deadline += chrono::microseconds(1000000 / summaryRate);
+		{
+			unique_lock<mutex> guard(progress.lock);
+			if (inputScript.active) { // Replaying a script, how many summaries fit in the batch depends on the speed of the CPU, so only the last one is drawn
+				progress.done.wait(guard, [&]() { return progress.finished; });
+				break;
+			}
+			if (progress.done.wait_until(guard, deadline, [&]() { return progress.finished; })) break; // Woken up as soon as the thread is done
+		}
+
+		chrono::nanoseconds started(progress.started.load(memory_order_relaxed));
+		drawUltraFastSummary(progress, playedBefore, chrono::duration<double>(chrono::steady_clock::now().time_since_epoch() - started).count());
 	}
+	worker.join();
 
-	int value = updateCredits(firstCol, secondCol, thirdCol);
+	drawUltraFastSummary(progress, playedBefore, progress.seconds);
+}
 
-	credit += value;
-	stats["Earned"] += value;
+/**
+ * @brief Adds the counters of one Stats to another, e.g. to merge the results of the threads of the simulator.
+ *
+ * @param total Stats where the counters are added.
+ * @param part Stats to add.
+ */
+void mergeStats(Stats& total, const Stats& part) {
+
+	for (const StatName& stat : statNames) {
+		total.*stat.value += part.*stat.value;
+	}
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		total.tiers[prize] += part.tiers[prize];
+	}
 }
 
 /**
@@ -666,12 +2104,9 @@ void ultraFastMode() {
  */
 int playGame() {
 
-	stats["Jackpots"] = 0; // Initialise nr occurrences of Jackpots
-	stats["2Symbols"] = 0; // Initialise nr occurrences of 2 Symbols
-	stats["Diamonds"] = 0; // Initialise nr occurrences of Diamonds
-	stats["Total"] = 0;    // Initialise nr of games played
-	stats["Spent"] = 0;    // Initialise nr of credits spent
-	stats["Earned"] = 0;   // Initialise nr of credits earned
+	stats = Stats(); // Initialise all the counters to 0
+
+	SpinState spin; // State of the spin, created once for the whole session and reused by every spin
 
 	char game = '0';
 
@@ -682,7 +2117,7 @@ int playGame() {
 
 			displayCentralMessage("Which mode do you want to play? Normal: 1  ||  Fast: 2  ||  Ultra-Fast: 3", "Press 0 to see the rules of the game.");
 
-			game = getch();
+			game = readKey();
 
 			if (game == '0') printRules();
 
@@ -694,13 +2129,13 @@ int playGame() {
 		displayCentralMessage("You are playing Normal Mode...", "Let's start...");
 
 		credit -= price;
-		stats["Spent"] += price;
+		stats.spent += price;
 
 		banner();
 
 		waitForKey();
 
-		evalResult(slotMachine());
+		evalResult(slotMachine(spin));
 	}
 
 	else if (game == '2') { // If user chose to play Fast Mode
@@ -720,19 +2155,19 @@ int playGame() {
 
 
 			credit -= price;
-			stats["Spent"] += price;
+			stats.spent += price;
 
-			evalResult(slotMachine());
+			evalResult(slotMachine(spin), autoContinue);
 
 			if (tempGameCounter == 10) {
 
-				clear();
-				banner();
-				mvprintw(LINES / 2, 28, "You already played %d games. Do you want to continue? (No: 0  OR  Yes: 1)", stats["Total"]);
+				newScreen();
+				renderPrint(LINES / 2, 28, "You already played %lld games. Do you want to continue? (No: 0  OR  Yes: 1)", stats.total);
+				renderPresent();
 
 				do
 				{
-					again = getch();
+					again = readKey();
 				} while (again != '0' && again != '1');
 
 				if (again == '0') break;
@@ -741,11 +2176,10 @@ int playGame() {
 
 		} while (credit >= price);
 
-		clear();
-		banner();
+		newScreen();
 
-		mvprintw(LINES / 2, 50, "You played %d games!", stats["Total"]);
-		mvaddstr((LINES / 2) + 1, 51, "Congratulations!!");
+		renderPrint(LINES / 2, 50, "You played %lld games!", stats.total);
+		renderText((LINES / 2) + 1, 51, "Congratulations!!");
 
 		waitForKey();
 	}
@@ -756,47 +2190,38 @@ int playGame() {
 
 		waitForKey();
 
-		int tempGameCounter = 0; // To count each games until reach n-hundred
 		char again; // To check if user wants to keep playing after X attempts
 
 		do
 		{
-			printFrame();
-			printRotCols();
+			ultraFastBatch(100);
 
-			tempGameCounter++;
-
-			credit -= price;
-			stats["Spent"] += price;
-
-			ultraFastMode();
+			if (credit >= price) { // The batch played all its 100 games
 
-			if (tempGameCounter == 100) {
-
-				clear();
-				banner();
-				mvprintw(LINES / 2, 28, "You already played %d games. Do you want to continue? (No: 0  OR  Yes: 1)", stats["Total"]);
+				newScreen();
+				renderPrint(LINES / 2, 28, "You already played %lld games. Do you want to continue? (No: 0  OR  Yes: 1)", stats.total);
+				renderPresent();
 
 				do
 				{
-					again = getch();
+					again = readKey();
 				} while (again != '0' && again != '1');
 
 				if (again == '0') break;
-				else tempGameCounter = 0;
 			}
 
 		} while (credit >= price);
 
 
-		clear();
-		banner();
+		newScreen();
 
-		mvprintw(LINES / 2, 50, "You played %d games!", stats["Total"]);
-		mvaddstr((LINES / 2) + 1, 51, "Congratulations!!");
+		renderPrint(LINES / 2, 50, "You played %lld games!", stats.total);
+		renderText((LINES / 2) + 1, 51, "Congratulations!!");
 
 		waitForKey();
 	}
+	mergeStats(sessionStats, stats);
+
 	return 1;
 }
 
@@ -805,22 +2230,65 @@ int playGame() {
  *
  */
 void displayStats() {
-	clear();
-	banner();
-
 	displayCentralMessage("Here's the Statistics of your game:", "Press [ENTER] to see");
 	waitForKey();
 
-	clear();
-	banner();
+	newScreen();
+
+	const int lastLine = LINES - 4; // Last line the stats can use, the ones below it have the credit and the prompt
+
+	int line = 14;
+	for (const StatName& stat : statNames) {
+		if (stat.value == &Stats::spent) line++; // Leave an empty line between the results and the cash-flow
+
+		renderPrint(line++, 45, stat.sentence, stats.*stat.value);
+	}
+
+	if (stats.total > 0 && line + 4 <= lastLine) { // Left out if the screen is too short for its 4 lines
+		StatsSummary summary = summarizeStats(stats);
+
+		renderPrint(++line, 45, "On average a game left you %+.2f credits (standard deviation %.2f).", summary.meanNet, summary.deviation);
+		if (stats.total > 1) renderPrint(++line, 45, "RTP %.1f%% (95%% confidence interval %.1f%% - %.1f%%).", 100 * summary.rtp, 100 * (summary.rtp - summary.rtpMargin), 100 * (summary.rtp + summary.rtpMargin));
+		else renderPrint(++line, 45, "RTP %.1f%% (play more games to see how sure it is).", 100 * summary.rtp);
+
+		for (unsigned short int prize = TWO_SYMBOLS; prize < PRIZES; prize++) { // 3 prizes per line
+			if ((prize - TWO_SYMBOLS) % 3 == 0) line++;
+			renderPrint(line, 45 + (prize - TWO_SYMBOLS) % 3 * 24, "%dpts: %.1f%% of games", prizePoints[prize], 100.0 * stats.tiers[prize] / stats.total);
+		}
+	}
+
+	waitForKey();
+
+	if (sessionStats.total == 0) return;
+
+	newScreen();
 
-	mvprintw(14, 45, "You played a Total of %d game(s).", stats["Total"]);
-	mvprintw(15, 45, "You got a Jackpot in %d of them.", stats["Jackpots"]);
-	mvprintw(16, 45, "You got 2 Symbols in %d of them.", stats["2Symbols"]);
-	mvprintw(17, 45, "And you got Diamonds %d time(s).", stats["Diamonds"]);
+	renderPrint(10, 30, "Prizes of all the %lld game(s) you played:", sessionStats.total);
 
-	mvprintw(19, 45, "You spent %d credits.", stats["Spent"]);
-	mvprintw(20, 45, "And you earned %d credits.", stats["Earned"]);
+	long long mostGames = *max_element(sessionStats.tiers, sessionStats.tiers + PRIZES);
+
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) { // One bar per prize, the longest one is 50 characters
+		int bar = (int)(50 * sessionStats.tiers[prize] / mostGames);
+		char bars[51];
+
+		memset(bars, '#', bar);
+		bars[bar] = '\0';
+		renderPrint(12 + prize, 30, "%-20s %6.2f%% %s", prizeNames[prize], 100.0 * sessionStats.tiers[prize] / sessionStats.total, bars);
+	}
+
+	if (sessionLengths.values > 0) {
+		renderPrint(20, 30, "Your credit ran out after %llu game(s).", sessionLengths.longest);
+	}
+	else {
+		renderPrint(20, 30, "You still have credits to play %d more game(s).", credit / price);
+	}
+
+	if (reelArea.frames > 0 && 22 <= lastLine) {
+		renderMeasured(22, 30, "The slot sent %.1f bytes per frame, %s (%llu frames).", (double)reelArea.bytes / reelArea.frames, reelArea.estimated ? "estimated" : "measured", reelArea.frames);
+	}
+	if (frameClock.frames > 0 && 23 <= lastLine) {
+		renderMeasured(23, 30, "Frames took %.1fms (p50), %.1fms (p99), target %.1fms, %llu skipped.", frameTimePercentile(0.5), frameTimePercentile(0.99), 1000.0 / framesPerSecond, frameClock.skipped);
+	}
 
 	waitForKey();
 }
@@ -838,8 +2306,7 @@ void loopGame() {
 		do {
 			displayCentralMessage("Do you want to play again? Maybe it's your chance to win the Jackpot! (No: 0  OR  Yes: 1) ");
 
-			nodelay(stdscr, FALSE); // Causes getch() to be a blocking call. the program stops until some input is given
-			again = getch();
+			again = readKey();
 
 			if (again == '0') {
 				displayStats();
@@ -848,6 +2315,8 @@ void loopGame() {
 			}
 		} while (again != '0' && again != '1');
 	}
+	if (credit < price) recordLength(sessionLengths, sessionStats.total); // The session ran until the credit ran out
+
 	displayStats();
 	cashOut();
 }
@@ -860,27 +2329,114 @@ void exitGame() {
 	displayCentralMessage("Bye!");
 	waitForKey();
 
-	clear();
-	refresh();
-	endwin(); // Closes PDCurses
+	renderClear();
+	renderPresent();
+	freeLayers();
+	renderEnd(); // Closes PDCurses
 }
 
+#ifndef FRUIT_MACHINE_TOOLS // Tools.cpp includes this file and has its own main()
+
 /**
  * @brief Main function. It initialises ncurses and the random seed, and sets some options related to the screen. Then it starts the main game by calling the loopGame function. After the game has ended, it calls the exitGame function and exits the program.
+ * The benchmarks and the analysis tools (--audit, --simulate, --sessions, --ruin, --rtp, --bench, --playback and --compare) are a separate program, see Tools.cpp.
+ * "--record FILE" records everything the game draws to FILE.
+ * "--export FILE" writes the payout and session length histograms of the game to a CSV file.
+ * "--ansi-reels" writes the rotating columns straight to the terminal with ANSI escape codes instead of going through curses (not on Windows).
+ * "--script FILE" plays the game with the keys of an input script instead of the keyboard, and "--renderer null" plays it without a screen.
+ * "--seed S" chooses the random seed (the current time by default).
+ * "--fps N" chooses the frame rate of the rotating columns (20 by default).
+ * "--auto-continue MS" chooses how long the result of a Fast Mode game is shown before the next game starts by itself (by default it waits for a key).
+ * "--rng xoshiro" or "--rng philox" chooses the random number generator used by the game.
  *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
  * @return int
  */
-int main() {
+int main(int argc, char* argv[]) {
+
+	unsigned long long seed = (unsigned long long)time(NULL);   // Random seed, the current time unless --seed is used
+	const char* recording = NULL;                               // File for --record
+	const char* script = NULL;                                  // Input script for --script
+	const char* exportPath = NULL;                              // CSV file for --export
+	RendererBackend backend = CURSES_RENDERER;                  // Renderer of the game, chosen with --renderer
+
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+
+		if (option == "--record" && i + 1 < argc) recording = argv[++i];
+		else if (option == "--script" && i + 1 < argc) script = argv[++i];
+		else if (option == "--export" && i + 1 < argc) exportPath = argv[++i];
+#ifdef ANSI_REELS
+		else if (option == "--ansi-reels") ansiReels.enabled = true;
+#endif
+		else if (option == "--renderer" && i + 1 < argc) {
+			string name = argv[++i];
+
+			if (name == rendererNames[CURSES_RENDERER]) backend = CURSES_RENDERER;
+			else if (name == rendererNames[NULL_RENDERER]) backend = NULL_RENDERER;
+			else { // The recording renderer is chosen with --record
+				cout << "Unknown renderer: " << name << endl;
+				return 1;
+			}
+		}
+		else if (option == "--fps" && i + 1 < argc) framesPerSecond = min(max(atoi(argv[++i]), 1), 1000);
+		else if (option == "--auto-continue" && i + 1 < argc) autoContinue = max(atoi(argv[++i]), -1);
+		else if (option == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+		else if (option == "--rng" && i + 1 < argc) {
+			string name = argv[++i];
+
+			if (!chooseRng(name)) {
+				cout << "Unknown random number generator: " << name << endl;
+				return 1;
+			}
+		}
+		else {
+			cout << "Unknown option: " << option << endl;
+			return 1;
+		}
+	}
+
+	xoshiroRng = Xoshiro256(seed);
+	philoxRng = Philox4x32(seed);
 
-	initscr();		// initialise pdcurses
-	noecho();       // don't print character pressed to end the loop
-	cbreak();       // don't wait for user to press ENTER after pressing a key
-	curs_set(0);		// hide the cursor
+	if (backend == NULL_RENDERER && (script == NULL || recording != NULL)) {
+		cout << "The null renderer needs an input script (--script) and can't be recorded" << endl;
+		return 1;
+	}
+	if (script != NULL && !loadInputScript(script)) {
+		cout << "Couldn't read the input script " << script << endl;
+		return 1;
+	}
+	renderer.backend = backend;
+
+	if (renderer.backend != NULL_RENDERER) {
+		initscr();		// initialise pdcurses
+		noecho();       // don't print character pressed to end the loop
+		cbreak();       // don't wait for user to press ENTER after pressing a key
+		curs_set(0);		// hide the cursor
+	}
 
-	srand((unsigned int)time(NULL));
+	if (recording != NULL && !startRecording(recording)) {
+		endwin();
+		cout << "Couldn't create the recording " << recording << endl;
+		return 1;
+	}
 
 	loopGame();
 	exitGame();
 
+	stopRecording();
+
+	if (exportPath != NULL && !exportHistograms(exportPath, sessionStats, sessionLengths)) cout << "Couldn't export the histograms to " << exportPath << endl;
+
+	if (script != NULL) {
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - inputScript.start;
+
+		cout << "Played " << inputScript.next << " key(s) of " << script << " in " << elapsed.count() << " s (" << frameClock.frames << " frames, " << stats.total << " games)" << endl;
+	}
+
 	return 0;
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,1717 @@
+/**
+ * @file Tools.cpp
+ * @brief Benchmarks and analysis tools of the Fruit Machine: payout audits, simulators, exact odds, the Markov chain solver and the recordings.
+ * They are a separate program, so the game doesn't carry the counting operator new, the SIMD code or the tools. Source.cpp is included whole (without its main()), so the tools measure and check the very same code the game runs.
+ *
+ */
+
+#define FRUIT_MACHINE_TOOLS // Leaves the main() of the game out
+#include "Source.cpp"
+
+#include <bitset> // To count the bits of the SIMD masks
+#include <new> // To count heap allocations in the benchmarks
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86 // SSE2 and AVX2 versions of the batch evaluator can be compiled
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h> // To use __cpuid()
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2"))) // Lets gcc/clang compile SSE2 and AVX2 code in a function without enabling it for the whole program
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+atomic<unsigned long long> allocations(0); // Number of heap allocations done with new since the program started. Used by the benchmarks to report allocations per operation
+
+/**
+ * @brief Replaces the global operator new so every heap allocation is counted in the allocations variable.
+ *
+ * @param size Number of bytes to allocate.
+ * @return void* Returns the allocated memory.
+ */
+void* operator new(size_t size) {
+
+	allocations++;
+
+	if (void* memory = malloc(size ? size : 1)) return memory;
+
+	throw bad_alloc();
+}
+
+/**
+ * @brief Frees memory allocated by the counting operator new.
+ *
+ * @param memory Memory to free.
+ */
+void operator delete(void* memory) noexcept {
+	free(memory);
+}
+
+/**
+ * @brief Sized version of operator delete, which some compilers call instead of the one above.
+ *
+ * @param memory Memory to free.
+ */
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+}
+
+/**
+ * @brief Exact odds of the game. As only the middle line counts, there are only 13 x 13 x 13 = 2197 results, all equally likely.
+ *
+ */
+struct Odds {
+	long long outcomes = 0;        // Nr of different results
+	long long ways[PRIZES] = {};   // Nr of results that give each prize
+	long long points = 0;          // Sum of the points of all the results
+	long long squaredPoints = 0;   // Sum of the squares of the points of all the results, for the variance
+};
+
+/**
+ * @brief Works out the exact odds of the game by scoring every possible result once with the rules of the game.
+ *
+ * @return Odds Returns the odds of every prize and the sums needed for the expected prize and its variance.
+ */
+Odds exactOdds() {
+
+	Odds odds;
+	Stats ignored; // scoreSpin() needs somewhere to count, but these counts aren't needed
+
+	for (unsigned short int first = 0; first < SYMBOLS; first++) {
+		for (unsigned short int second = 0; second < SYMBOLS; second++) {
+			for (unsigned short int third = 0; third < SYMBOLS; third++) {
+				int points = scoreSpin(Symbol(first), Symbol(second), Symbol(third), ignored);
+
+				odds.outcomes++;
+				odds.ways[prizeOf(points)]++;
+				odds.points += points;
+				odds.squaredPoints += (long long)points * points;
+			}
+		}
+	}
+	return odds;
+}
+
+/**
+ * @brief Headless spin engine used for payout audits. Plays the given number of spins with the same rules as the game but without calling curses at all, so it runs as fast as the CPU allows.
+ * The spins are played as sessions back to back: each one starts with the credit of the game and ends when there isn't enough credit for another game.
+ *
+ * @param spins Number of spins to play.
+ * @param sessions Histogram where the length of every session that ran out of credit is counted.
+ * @return Stats Returns the aggregated stats of all the spins.
+ */
+Stats headlessSpins(unsigned long long spins, LengthHistogram& sessions) {
+
+	Stats tally;
+	long long wallet = startingCredit; // Credit of the current session, which starts like the game does
+	unsigned long long games = 0;      // Games of the current session
+
+	for (unsigned long long i = 0; i < spins; i++) {
+		int value = headlessSpin(tally);
+
+		tally.spent += price;
+		tally.earned += value;
+
+		wallet += value - price;
+		games++;
+
+		if (wallet < price) { // The credit ran out, a new session starts
+			recordLength(sessions, games);
+			wallet = startingCredit;
+			games = 0;
+		}
+	}
+	return tally;
+}
+
+/**
+ * @brief Instruction sets the batch evaluator can use. The best one the CPU supports is chosen when the program starts.
+ *
+ */
+enum SimdLevel : unsigned char { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_LEVELS };
+
+const char* const simdNames[SIMD_LEVELS] = { "scalar", "sse2", "avx2" }; // Names of the instruction sets, for the benchmarks
+
+/**
+ * @brief Asks the CPU which instruction sets it supports.
+ *
+ * @return SimdLevel Returns the best instruction set the batch evaluator can use on this CPU.
+ */
+SimdLevel detectSimd() {
+#if defined(SIMD_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6); // The CPU supports AVX and the OS saves the AVX registers
+
+	bool avx2 = false;
+	if (avx && maxLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return avx2 ? SIMD_AVX2 : sse2 ? SIMD_SSE2 : SIMD_SCALAR;
+#elif defined(SIMD_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+	return SIMD_SCALAR;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+SimdLevel simdLevel = detectSimd(); // Instruction set used by the batch evaluator
+
+/**
+ * @brief What the batch evaluator counts. Everything else (prizes, 2 Symbols) is worked out from these at the end of the batch.
+ *
+ */
+struct BatchCounts {
+	unsigned long long matches = 0;         // Spins with at least two equal symbols (Jackpots included)
+	unsigned long long jackpots = 0;        // Spins with three equal symbols
+	unsigned long long diamondJackpots = 0; // Spins with three DIAMONDs
+	unsigned long long diamonds = 0;        // DIAMONDs in all the spins
+	unsigned long long twoDiamonds = 0;     // Spins with at least two DIAMONDs (DIAMOND Jackpots included)
+	unsigned long long diamondMatches = 0;  // Spins with at least two equal symbols and at least one DIAMOND
+};
+
+/**
+ * @brief Scalar version of the batch evaluator, used when the CPU has no SIMD and for the spins left at the end of a batch. It has no branches.
+ *
+ * @param first Symbols in the middle line of the first column, one per spin.
+ * @param second Symbols in the middle line of the second column, one per spin.
+ * @param third Symbols in the middle line of the third column, one per spin.
+ * @param spins Number of spins.
+ * @param counts Where the results are counted.
+ */
+void countBatchScalar(const unsigned char* first, const unsigned char* second, const unsigned char* third, size_t spins, BatchCounts& counts) {
+
+	for (size_t i = 0; i < spins; i++) {
+		bool firstSecond = first[i] == second[i];
+		bool firstThird = first[i] == third[i];
+		bool secondThird = second[i] == third[i];
+		bool jackpot = firstSecond && secondThird;
+
+		counts.matches += firstSecond | firstThird | secondThird;
+		counts.jackpots += jackpot;
+		bool firstDiamond = first[i] == DIAMOND;
+		bool secondDiamond = second[i] == DIAMOND;
+		bool thirdDiamond = third[i] == DIAMOND;
+
+		counts.diamondJackpots += jackpot & firstDiamond;
+		counts.diamonds += firstDiamond + secondDiamond + thirdDiamond;
+		counts.twoDiamonds += (firstDiamond & secondDiamond) | (firstDiamond & thirdDiamond) | (secondDiamond & thirdDiamond);
+		counts.diamondMatches += (firstSecond | firstThird | secondThird) & (firstDiamond | secondDiamond | thirdDiamond);
+	}
+}
+
+#ifdef SIMD_X86
+/**
+ * @brief SSE2 version of the batch evaluator. Compares 16 spins at a time and counts the bits of the resulting masks.
+ *
+ * @param first Symbols in the middle line of the first column, one per spin.
+ * @param second Symbols in the middle line of the second column, one per spin.
+ * @param third Symbols in the middle line of the third column, one per spin.
+ * @param spins Number of spins.
+ * @param counts Where the results are counted.
+ */
+TARGET_SSE2 void countBatchSse2(const unsigned char* first, const unsigned char* second, const unsigned char* third, size_t spins, BatchCounts& counts) {
+
+	const __m128i diamond = _mm_set1_epi8(DIAMOND);
+
+	size_t i = 0;
+	for (; i + 16 <= spins; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(first + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(second + i));
+		__m128i c = _mm_loadu_si128((const __m128i*)(third + i));
+
+		__m128i firstSecond = _mm_cmpeq_epi8(a, b);
+		__m128i secondThird = _mm_cmpeq_epi8(b, c);
+		__m128i jackpot = _mm_and_si128(firstSecond, secondThird);
+		__m128i match = _mm_or_si128(_mm_or_si128(firstSecond, secondThird), _mm_cmpeq_epi8(a, c));
+		__m128i firstDiamond = _mm_cmpeq_epi8(a, diamond);
+		__m128i secondDiamond = _mm_cmpeq_epi8(b, diamond);
+		__m128i thirdDiamond = _mm_cmpeq_epi8(c, diamond);
+		__m128i twoDiamonds = _mm_or_si128(_mm_or_si128(_mm_and_si128(firstDiamond, secondDiamond), _mm_and_si128(firstDiamond, thirdDiamond)), _mm_and_si128(secondDiamond, thirdDiamond));
+		__m128i anyDiamond = _mm_or_si128(_mm_or_si128(firstDiamond, secondDiamond), thirdDiamond);
+
+		counts.matches += bitset<16>(_mm_movemask_epi8(match)).count();
+		counts.jackpots += bitset<16>(_mm_movemask_epi8(jackpot)).count();
+		counts.diamondJackpots += bitset<16>(_mm_movemask_epi8(_mm_and_si128(jackpot, firstDiamond))).count();
+		counts.diamonds += bitset<16>(_mm_movemask_epi8(firstDiamond)).count()
+			+ bitset<16>(_mm_movemask_epi8(secondDiamond)).count()
+			+ bitset<16>(_mm_movemask_epi8(thirdDiamond)).count();
+		counts.twoDiamonds += bitset<16>(_mm_movemask_epi8(twoDiamonds)).count();
+		counts.diamondMatches += bitset<16>(_mm_movemask_epi8(_mm_and_si128(match, anyDiamond))).count();
+	}
+	countBatchScalar(first + i, second + i, third + i, spins - i, counts);
+}
+
+/**
+ * @brief AVX2 version of the batch evaluator. Same as the SSE2 one but with 32 spins at a time.
+ *
+ * @param first Symbols in the middle line of the first column, one per spin.
+ * @param second Symbols in the middle line of the second column, one per spin.
+ * @param third Symbols in the middle line of the third column, one per spin.
+ * @param spins Number of spins.
+ * @param counts Where the results are counted.
+ */
+TARGET_AVX2 void countBatchAvx2(const unsigned char* first, const unsigned char* second, const unsigned char* third, size_t spins, BatchCounts& counts) {
+
+	const __m256i diamond = _mm256_set1_epi8(DIAMOND);
+
+	size_t i = 0;
+	for (; i + 32 <= spins; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(first + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(second + i));
+		__m256i c = _mm256_loadu_si256((const __m256i*)(third + i));
+
+		__m256i firstSecond = _mm256_cmpeq_epi8(a, b);
+		__m256i secondThird = _mm256_cmpeq_epi8(b, c);
+		__m256i jackpot = _mm256_and_si256(firstSecond, secondThird);
+		__m256i match = _mm256_or_si256(_mm256_or_si256(firstSecond, secondThird), _mm256_cmpeq_epi8(a, c));
+		__m256i firstDiamond = _mm256_cmpeq_epi8(a, diamond);
+		__m256i secondDiamond = _mm256_cmpeq_epi8(b, diamond);
+		__m256i thirdDiamond = _mm256_cmpeq_epi8(c, diamond);
+		__m256i twoDiamonds = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(firstDiamond, secondDiamond), _mm256_and_si256(firstDiamond, thirdDiamond)), _mm256_and_si256(secondDiamond, thirdDiamond));
+		__m256i anyDiamond = _mm256_or_si256(_mm256_or_si256(firstDiamond, secondDiamond), thirdDiamond);
+
+		counts.matches += bitset<32>((unsigned int)_mm256_movemask_epi8(match)).count();
+		counts.jackpots += bitset<32>((unsigned int)_mm256_movemask_epi8(jackpot)).count();
+		counts.diamondJackpots += bitset<32>((unsigned int)_mm256_movemask_epi8(_mm256_and_si256(jackpot, firstDiamond))).count();
+		counts.diamonds += bitset<32>((unsigned int)_mm256_movemask_epi8(firstDiamond)).count()
+			+ bitset<32>((unsigned int)_mm256_movemask_epi8(secondDiamond)).count()
+			+ bitset<32>((unsigned int)_mm256_movemask_epi8(thirdDiamond)).count();
+		counts.twoDiamonds += bitset<32>((unsigned int)_mm256_movemask_epi8(twoDiamonds)).count();
+		counts.diamondMatches += bitset<32>((unsigned int)_mm256_movemask_epi8(_mm256_and_si256(match, anyDiamond))).count();
+	}
+	countBatchScalar(first + i, second + i, third + i, spins - i, counts);
+}
+#endif
+
+/**
+ * @brief Batch evaluator. Scores many spins at once from the symbols in the middle line of each column (one array per column) and adds the results to the given Stats, exactly like calling scoreSpin() for each spin would.
+ * Instead of going through the if/else chain of scoreSpin() for every spin, it only counts matches, Jackpots and DIAMONDs, which can be done with SIMD, and works the prizes out from the counts:
+ * a DIAMOND Jackpot is 1000pts, any other Jackpot is 150pts, two equal symbols are 10pts and every DIAMOND outside a DIAMOND Jackpot is 50pts.
+ *
+ * @param first Symbols in the middle line of the first column, one per spin.
+ * @param second Symbols in the middle line of the second column, one per spin.
+ * @param third Symbols in the middle line of the third column, one per spin.
+ * @param spins Number of spins.
+ * @param tally Stats where the results are counted.
+ * @param level Instruction set to use. By default, the best one the CPU supports.
+ * @return long long Returns the amount of points of all the spins together.
+ */
+long long evaluateBatch(const unsigned char* first, const unsigned char* second, const unsigned char* third, size_t spins, Stats& tally, SimdLevel level = simdLevel) {
+
+	BatchCounts counts;
+
+	switch (level)
+	{
+#ifdef SIMD_X86
+	case SIMD_AVX2: countBatchAvx2(first, second, third, spins, counts);
+		break;
+
+	case SIMD_SSE2: countBatchSse2(first, second, third, spins, counts);
+		break;
+#endif
+	default: countBatchScalar(first, second, third, spins, counts);
+		break;
+	}
+
+	long long points = 1000 * counts.diamondJackpots + 150 * (counts.jackpots - counts.diamondJackpots) + 10 * (counts.matches - counts.jackpots) + 50 * (counts.diamonds - 3 * counts.diamondJackpots);
+
+	unsigned long long twoDiamonds = counts.twoDiamonds - counts.diamondJackpots;                // Two DIAMONDs are always two equal symbols
+	unsigned long long twoSymbolsDiamond = counts.diamondMatches - counts.diamondJackpots - twoDiamonds; // Two equal symbols and exactly one DIAMOND
+	unsigned long long oneDiamond = counts.diamonds - 3 * counts.diamondJackpots - 2 * twoDiamonds - twoSymbolsDiamond;
+
+	tally.tiers[DIAMOND_JACKPOT] += counts.diamondJackpots;
+	tally.tiers[JACKPOT] += counts.jackpots - counts.diamondJackpots;
+	tally.tiers[TWO_DIAMONDS] += twoDiamonds;
+	tally.tiers[TWO_SYMBOLS_DIAMOND] += twoSymbolsDiamond;
+	tally.tiers[ONE_DIAMOND] += oneDiamond;
+	tally.tiers[TWO_SYMBOLS] += counts.matches - counts.jackpots - twoDiamonds - twoSymbolsDiamond;
+	tally.tiers[NO_PRIZE] += spins - counts.matches - oneDiamond;
+
+	tally.jackpots += counts.jackpots;
+	tally.twoSymbols += counts.matches - counts.jackpots;
+	tally.diamonds += counts.diamonds;
+	tally.total += spins;
+
+	return points;
+}
+
+constexpr double ruinEpsilon = 1e-15; // Probability below which the highest credits of the Markov chain are dropped, so the solver only follows the credits that matter
+
+/**
+ * @brief Moves of the credit in one game of the Markov chain solver: the probability of each prize and how many states (steps of credit) it moves the credit.
+ *
+ */
+struct RuinMoves {
+	double odds[PRIZES] = {};    // Probability of each prize
+	long long states[PRIZES] = {}; // States moved by each prize, prize - price (negative if it's less than the price)
+};
+
+/**
+ * @brief Scalar version of one game of the Markov chain solver. Works out the probability of each credit after the game from the probabilities before it, adding up the 7 credits each one can come from in the same order as the SIMD versions, so they all give exactly the same result.
+ *
+ * @param before Probability of each credit before the game. It must be 0 outside the credits that can still play, and readable (0) for the states the moves come from.
+ * @param after Probability of each credit after the game.
+ * @param first First state worked out.
+ * @param last Last state worked out.
+ * @param moves Probability and size of the move of each prize.
+ */
+void propagateScalar(const double* before, double* after, long long first, long long last, const RuinMoves& moves) {
+
+	for (long long state = first; state <= last; state++) {
+		double probability = 0;
+		for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+			probability += moves.odds[prize] * before[state - moves.states[prize]];
+		}
+		after[state] = probability;
+	}
+}
+
+#ifdef SIMD_X86
+/**
+ * @brief SSE2 version of one game of the Markov chain solver. Works out 2 states at a time.
+ *
+ * @param before Probability of each credit before the game.
+ * @param after Probability of each credit after the game.
+ * @param first First state worked out.
+ * @param last Last state worked out.
+ * @param moves Probability and size of the move of each prize.
+ */
+TARGET_SSE2 void propagateSse2(const double* before, double* after, long long first, long long last, const RuinMoves& moves) {
+
+	long long state = first;
+
+	for (; state + 1 <= last; state += 2) {
+		__m128d probability = _mm_setzero_pd();
+		for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+			probability = _mm_add_pd(probability, _mm_mul_pd(_mm_set1_pd(moves.odds[prize]), _mm_loadu_pd(before + state - moves.states[prize])));
+		}
+		_mm_storeu_pd(after + state, probability);
+	}
+	propagateScalar(before, after, state, last, moves); // Last state, if there's one left
+}
+
+/**
+ * @brief AVX2 version of one game of the Markov chain solver. Same as the SSE2 one but with 4 states at a time.
+ *
+ * @param before Probability of each credit before the game.
+ * @param after Probability of each credit after the game.
+ * @param first First state worked out.
+ * @param last Last state worked out.
+ * @param moves Probability and size of the move of each prize.
+ */
+TARGET_AVX2 void propagateAvx2(const double* before, double* after, long long first, long long last, const RuinMoves& moves) {
+
+	long long state = first;
+
+	for (; state + 3 <= last; state += 4) {
+		__m256d probability = _mm256_setzero_pd();
+		for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+			probability = _mm256_add_pd(probability, _mm256_mul_pd(_mm256_set1_pd(moves.odds[prize]), _mm256_loadu_pd(before + state - moves.states[prize])));
+		}
+		_mm256_storeu_pd(after + state, probability);
+	}
+	propagateScalar(before, after, state, last, moves); // Last states, if there are less than 4 left
+}
+#endif
+
+/**
+ * @brief Exact distribution of the length of a session, worked out by the Markov chain solver.
+ *
+ */
+struct RuinSolution {
+	int step = 1;                  // Credits of one state of the chain (the greatest common divisor of the price and the prizes)
+	vector<double> busted;         // Probability of running out of credit by each game (busted[n] = by game n, busted[0] = 0)
+	double expectedLength = 0;     // Expected nr of games of a session, stopping at the horizon
+	double bustCredit = 0;         // Sum of the credit left times its probability, for the sessions that ran out of credit
+	double dropped = 0;            // Probability of the credits dropped for being below ruinEpsilon, an upper bound of the error
+	long long states = 0;          // Nr of states worked out, to see how many credits the chain had to follow
+};
+
+/**
+ * @brief Exact Markov chain solver of a session. Every game moves the credit by one of the 7 prizes minus the price with the exact odds of the game, so the probability of every credit after each game can be worked out from the probabilities after the previous one, without playing any game.
+ * The credits are counted in steps of the greatest common divisor of the price and the prizes (5 with the current paytable), and each game only works out the range of credits that can have some probability: from the credits just below the price (which ran out of credit and leave the chain) to the highest credit above ruinEpsilon plus the biggest prize.
+ *
+ * @param startCredit Credit at the start of the session.
+ * @param horizon Number of games to follow.
+ * @param level Optional parameter. Instruction set to use. By default, the best one the CPU supports.
+ * @return RuinSolution Returns the probability of running out of credit by each game and the expected length of the session.
+ */
+RuinSolution solveRuin(long long startCredit, unsigned long long horizon, SimdLevel level = simdLevel) {
+
+	RuinSolution solution;
+	RuinMoves moves;
+	Odds odds = exactOdds();
+
+	int step = price;
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) { // Greatest common divisor of the price and the prizes
+		int other = prizePoints[prize];
+		while (other != 0) {
+			int rest = step % other;
+			step = other;
+			other = rest;
+		}
+	}
+	solution.step = step;
+
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		moves.odds[prize] = (double)odds.ways[prize] / odds.outcomes;
+		moves.states[prize] = (prizePoints[prize] - price) / step;
+	}
+
+	long long up = *max_element(moves.states, moves.states + PRIZES);    // States won by the biggest prize
+	long long down = -*min_element(moves.states, moves.states + PRIZES); // States lost by a game without a prize
+	long long remainder = startCredit % step;                            // State i is a credit of remainder + i * step
+	long long lowest = (price - remainder + step - 1) / step;            // First state that can still play
+	long long highest = (startCredit - remainder) / step;                // Last state with some probability
+	long long padding = up;                                              // Extra states before state 0, so the moves of the lowest states can be read
+
+	solution.busted.assign(horizon + 1, startCredit < price ? 1.0 : 0.0);
+	if (startCredit < price) { // Not enough credit for a single game
+		solution.bustCredit = (double)startCredit;
+		return solution;
+	}
+
+	vector<double> current(padding + highest + 1, 0.0), next;
+	current[padding + highest] = 1;
+	double alive = 1;
+
+	for (unsigned long long game = 1; game <= horizon; game++) {
+		solution.expectedLength += alive;
+
+		long long last = highest + up;
+		current.resize(padding + last + down + 1, 0.0); // Credits above highest are 0
+		next.resize(padding + last + 1, 0.0);           // Anything above last is from an older game, so it's cut
+
+		double* before = current.data() + padding;
+		double* after = next.data() + padding;
+
+		switch (level)
+		{
+#ifdef SIMD_X86
+		case SIMD_AVX2: propagateAvx2(before, after, lowest - down, last, moves);
+			break;
+
+		case SIMD_SSE2: propagateSse2(before, after, lowest - down, last, moves);
+			break;
+#endif
+		default: propagateScalar(before, after, lowest - down, last, moves);
+			break;
+		}
+		solution.states += last - lowest + down + 1;
+
+		double bust = 0;
+		for (long long state = lowest - down; state < lowest; state++) {
+			bust += after[state];
+			solution.bustCredit += after[state] * (remainder + state * step);
+			after[state] = 0;
+		}
+
+		highest = last;
+		while (highest > lowest && after[highest] < ruinEpsilon) {
+			solution.dropped += after[highest];
+			alive -= after[highest];
+			after[highest] = 0;
+			highest--;
+		}
+
+		alive -= bust;
+		solution.busted[game] = solution.busted[game - 1] + bust;
+		swap(current, next);
+	}
+	return solution;
+}
+
+constexpr unsigned long long chunkSpins = 1 << 20; // Nr of spins in each chunk of the simulator. Every chunk has its own random number stream
+constexpr size_t batchSpins = 4096;                 // Nr of spins given to the batch evaluator at once
+
+/**
+ * @brief Plays the given number of spins with the given random number generator. The symbols are generated in batches and scored with the batch evaluator.
+ *
+ * @param rng Random number generator of the chunk.
+ * @param spins Number of spins to play.
+ * @return Stats Returns the stats of the spins.
+ */
+template <typename Engine>
+Stats simulateChunk(Engine& rng, unsigned long long spins) {
+
+	Stats tally;
+	unsigned char first[batchSpins], second[batchSpins], third[batchSpins]; // Middle line of each column, one symbol per spin
+
+	while (spins > 0) {
+		size_t batch = (size_t)min<unsigned long long>(spins, batchSpins);
+
+		for (size_t i = 0; i < batch; i++) {
+			first[i] = randomSymbol(rng);
+			second[i] = randomSymbol(rng);
+			third[i] = randomSymbol(rng);
+		}
+
+		tally.spent += price * (long long)batch;
+		tally.earned += evaluateBatch(first, second, third, batch, tally);
+
+		spins -= batch;
+	}
+	return tally;
+}
+
+/**
+ * @brief Plays one chunk of the simulator. The chunk gets its own random number stream, worked out from the seed of the simulation and the number of the chunk, so the result of a chunk doesn't depend on which thread plays it.
+ * With Philox, every chunk jumps straight to its own part of the stream (2^34 numbers each). With xoshiro, every chunk gets its own seed.
+ *
+ * @param seed Seed of the whole simulation.
+ * @param chunk Number of the chunk.
+ * @param spins Number of spins in the chunk.
+ * @return Stats Returns the stats of the chunk.
+ */
+Stats simulateChunk(unsigned long long seed, unsigned long long chunk, unsigned long long spins) {
+
+	if (rngEngine == PHILOX) {
+		Philox4x32 rng(seed);
+		rng.discard(chunk << 34);
+		return simulateChunk(rng, spins);
+	}
+
+	Xoshiro256 rng(seed ^ (chunk * 0xD1B54A32D192ED03ULL)); // Multiplying by an odd constant spreads the chunk number over all the bits
+	return simulateChunk(rng, spins);
+}
+
+/**
+ * @brief Multi-threaded Monte Carlo simulator. The spins are split in chunks, and the threads keep taking the next chunk until there are none left. Each thread counts in its own Stats and they are all merged at the end.
+ * As every chunk has its own random number stream, the result is always the same for the same seed and number of spins, no matter how many threads are used.
+ *
+ * @param spins Number of spins to play.
+ * @param seed Seed of the simulation.
+ * @param threads Number of threads to use.
+ * @param firstChunk Optional parameter. Chunk to start from, to carry on a simulation that already played the chunks before it.
+ * @return Stats Returns the aggregated stats of all the spins.
+ */
+Stats simulateSpins(unsigned long long spins, unsigned long long seed, unsigned int threads, unsigned long long firstChunk = 0) {
+
+	unsigned long long chunks = (spins + chunkSpins - 1) / chunkSpins;
+	atomic<unsigned long long> nextChunk(0); // Next chunk to be played by any of the threads
+
+	Stats total;
+	mutex totalMutex; // Protects total while the threads merge their results
+
+	auto worker = [&]() {
+		Stats tally; // Counters of this thread only, so the threads don't share anything while they play
+
+		for (unsigned long long chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+			unsigned long long chunkSize = (chunk == chunks - 1) ? spins - chunk * chunkSpins : chunkSpins;
+			mergeStats(tally, simulateChunk(seed, firstChunk + chunk, chunkSize));
+		}
+
+		lock_guard<mutex> lock(totalMutex);
+		mergeStats(total, tally);
+	};
+
+	vector<thread> workers;
+	for (unsigned int i = 1; i < threads; i++) {
+		workers.push_back(thread(worker));
+	}
+	worker(); // The current thread also plays
+
+	for (thread& t : workers) {
+		t.join();
+	}
+	return total;
+}
+
+constexpr unsigned long long sessionChunk = 1024; // Nr of sessions in each chunk of the session simulator. Every chunk has its own random number stream
+
+/**
+ * @brief Settings of the session simulator.
+ *
+ */
+struct SessionSettings {
+	long long startCredit = startingCredit; // Credit every session starts with
+	unsigned long long spinCap = 1000000;   // Sessions that last this many games are stopped
+	long long target = 2 * startingCredit;  // Balance the sessions try to reach
+};
+
+/**
+ * @brief Results of the session simulator. Like Stats, the results of two threads are merged by adding them up.
+ *
+ */
+struct SessionResults {
+	Stats tally;                       // All the games of all the sessions
+	LengthHistogram lengths;           // Nr of games of the sessions that ran out of credit
+	LengthHistogram peaks;             // Highest credit of every session
+	unsigned long long sessions = 0;   // Nr of sessions played
+	unsigned long long busted = 0;     // Sessions that ran out of credit
+	unsigned long long capped = 0;     // Sessions stopped by the spin cap
+	unsigned long long reached = 0;    // Sessions that reached the target at some point
+};
+
+/**
+ * @brief Adds the results of one run of the session simulator to another.
+ *
+ * @param total Results where the other ones are added.
+ * @param part Results to add.
+ */
+void mergeSessionResults(SessionResults& total, const SessionResults& part) {
+
+	mergeStats(total.tally, part.tally);
+	mergeHistogram(total.lengths, part.lengths);
+	mergeHistogram(total.peaks, part.peaks);
+	total.sessions += part.sessions;
+	total.busted += part.busted;
+	total.capped += part.capped;
+	total.reached += part.reached;
+}
+
+/**
+ * @brief Plays whole sessions with the given random number generator: each one starts with the starting credit and plays until there isn't enough credit for another game or the spin cap is reached.
+ *
+ * @param rng Random number generator to use.
+ * @param sessions Number of sessions to play.
+ * @param settings Starting credit, spin cap and target of the sessions.
+ * @param results Where the results are added.
+ */
+template <typename Engine>
+void simulateSessions(Engine& rng, unsigned long long sessions, const SessionSettings& settings, SessionResults& results) {
+
+	for (unsigned long long session = 0; session < sessions; session++) {
+		long long wallet = settings.startCredit;
+		long long peak = wallet;
+		unsigned long long games = 0;
+
+		while (wallet >= price && games < settings.spinCap) {
+			Symbol first = randomSymbol(rng);
+			Symbol second = randomSymbol(rng);
+			Symbol third = randomSymbol(rng);
+
+			wallet += scoreSpin(first, second, third, results.tally) - price;
+			peak = max(peak, wallet);
+			games++;
+		}
+
+		results.tally.spent += price * (long long)games;
+		results.tally.earned += wallet - settings.startCredit + price * (long long)games;
+		results.sessions++;
+		if (wallet < price) {
+			results.busted++;
+			recordLength(results.lengths, games);
+		}
+		else results.capped++;
+		if (peak >= settings.target) results.reached++;
+		recordLength(results.peaks, (unsigned long long)peak);
+	}
+}
+
+/**
+ * @brief Plays one chunk of sessions with its own random number stream, like simulateChunk() does for spins. With Philox, the streams of the chunks are 2^34 numbers apart, which is enough for 1024 sessions of a few million games each.
+ *
+ * @param seed Seed of the simulation.
+ * @param chunk Index of the chunk.
+ * @param sessions Number of sessions of this chunk.
+ * @param settings Starting credit, spin cap and target of the sessions.
+ * @param results Where the results are added.
+ */
+void simulateSessionChunk(unsigned long long seed, unsigned long long chunk, unsigned long long sessions, const SessionSettings& settings, SessionResults& results) {
+
+	if (rngEngine == PHILOX) {
+		Philox4x32 rng(seed);
+		rng.discard(chunk << 34);
+		simulateSessions(rng, sessions, settings, results);
+		return;
+	}
+
+	Xoshiro256 rng(seed ^ (chunk * 0xD1B54A32D192ED03ULL));
+	simulateSessions(rng, sessions, settings, results);
+}
+
+/**
+ * @brief Multi-threaded session simulator (gambler's ruin). The sessions are split in chunks that the threads take one after the other, like simulateSpins() does, so the results only depend on the seed and the nr of sessions, not on the nr of threads.
+ *
+ * @param sessions Number of sessions to play.
+ * @param seed Seed of the simulation.
+ * @param threads Number of threads to use.
+ * @param settings Starting credit, spin cap and target of the sessions.
+ * @return SessionResults Returns the aggregated results of all the sessions.
+ */
+SessionResults simulateSessionRuns(unsigned long long sessions, unsigned long long seed, unsigned int threads, const SessionSettings& settings) {
+
+	unsigned long long chunks = (sessions + sessionChunk - 1) / sessionChunk;
+	atomic<unsigned long long> nextChunk(0);
+
+	SessionResults total;
+	mutex totalMutex;
+
+	auto worker = [&]() {
+		SessionResults results; // Results of this thread only
+
+		for (unsigned long long chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+			unsigned long long chunkSize = (chunk == chunks - 1) ? sessions - chunk * sessionChunk : sessionChunk;
+			simulateSessionChunk(seed, chunk, chunkSize, settings, results);
+		}
+
+		lock_guard<mutex> lock(totalMutex);
+		mergeSessionResults(total, results);
+	};
+
+	vector<thread> workers;
+	for (unsigned int i = 1; i < threads; i++) {
+		workers.push_back(thread(worker));
+	}
+	worker();
+
+	for (thread& t : workers) {
+		t.join();
+	}
+	return total;
+}
+
+/**
+ * @brief The way symbols used to be generated, with a local array of 13 strings built on every call and the chosen one returned by value. Only kept so the benchmark can show the difference against slotSymbols().
+ *
+ * @return string Random slot machine fruit symbol.
+ */
+string legacySlotSymbols() {
+
+	string symbols[13] = { "APPLES", "BANANA", "CHERRY", "LEMONS", "GRAPES", "ORANGE", "DIAMOND", "MELONS", "APRICOT", "KIWIS", "MANGO", "PEACH", "PEARS" };
+
+	return symbols[rand() % 13];
+}
+
+/**
+ * @brief Fills a column of the slot with random symbols.
+ *
+ * @param column Column to be filled.
+ */
+void fillColumn(Column& column) {
+
+	for (unsigned short int i = 0; i < 7; i++) {
+		column[i] = slotSymbols();
+	}
+}
+
+volatile size_t benchSink; // Every benchmark adds its results here, so the compiler can't optimise the measured code away
+
+/**
+ * @brief Measures how long it takes to generate the 21 symbols of a rotating frame (what printRotCols() does, without the screen) and how many heap allocations it needs, before and after the static symbol table.
+ *
+ * @param frames Number of frames to generate for each version.
+ */
+void benchSymbols(unsigned long long frames) {
+
+	size_t sink = 0;
+
+	unsigned long long before = allocations;
+	auto start = chrono::steady_clock::now();
+	for (unsigned long long frame = 0; frame < frames; frame++) {
+		for (unsigned short int i = 0; i < 21; i++) {
+			sink += legacySlotSymbols().length(); // Before: a string for every symbol
+		}
+	}
+	chrono::duration<double, nano> legacyTime = chrono::steady_clock::now() - start;
+	unsigned long long legacyAllocations = allocations - before;
+
+	before = allocations;
+	start = chrono::steady_clock::now();
+	for (unsigned long long frame = 0; frame < frames; frame++) {
+		for (unsigned short int i = 0; i < 21; i++) {
+			sink += (size_t)symbolCells[slotSymbols()]; // After: an index into the static table
+		}
+	}
+	chrono::duration<double, nano> tableTime = chrono::steady_clock::now() - start;
+	unsigned long long tableAllocations = allocations - before;
+
+	benchSink = benchSink + sink;
+
+	cout << "Symbols of a rotating frame (" << frames << " frames of 21 symbols)" << endl;
+	cout << "  before (strings):      " << legacyTime.count() / (frames * 21) << " ns/symbol, " << (double)legacyAllocations / frames << " allocations/frame" << endl;
+	cout << "  after (static table):  " << tableTime.count() / (frames * 21) << " ns/symbol, " << (double)tableAllocations / frames << " allocations/frame" << endl;
+}
+
+/**
+ * @brief Measures how long the given random number generator takes to generate a symbol.
+ *
+ * @param rng Random number generator to measure.
+ * @param symbols Number of symbols to generate.
+ * @return double Returns the nr of nanoseconds per symbol.
+ */
+template <typename Engine>
+double timeSymbols(Engine& rng, unsigned long long symbols) {
+
+	size_t sink = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned long long i = 0; i < symbols; i++) {
+		sink += randomSymbol(rng);
+	}
+	chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+	benchSink = benchSink + sink;
+
+	return elapsed.count() / symbols;
+}
+
+/**
+ * @brief Compares how long each random number generator takes to generate a symbol, against the old rand() % 13.
+ *
+ * @param symbols Number of symbols to generate with each generator.
+ */
+void benchRng(unsigned long long symbols) {
+
+	size_t sink = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned long long i = 0; i < symbols; i++) {
+		sink += rand() % 13;
+	}
+	chrono::duration<double, nano> randTime = chrono::steady_clock::now() - start;
+
+	benchSink = benchSink + sink;
+
+	Xoshiro256 xoshiro(1);
+	Philox4x32 philox(1);
+
+	cout << "Random symbols (" << symbols << " symbols)" << endl;
+	cout << "  rand() % 13:  " << randTime.count() / symbols << " ns/symbol" << endl;
+	cout << "  xoshiro:      " << timeSymbols(xoshiro, symbols) << " ns/symbol" << endl;
+	cout << "  philox:       " << timeSymbols(philox, symbols) << " ns/symbol" << endl;
+}
+
+/**
+ * @brief Compares how long it takes to score a spin with scoreSpin() and with the batch evaluator on every instruction set the CPU supports, and checks they all give the same result.
+ *
+ * @param rounds Number of times the same batch of spins is scored.
+ * @return true If every instruction set gave the same result as scoreSpin().
+ * @return false If one of them didn't, so its kernel is broken.
+ */
+bool benchEvaluate(unsigned long long rounds) {
+
+	unsigned char first[batchSpins], second[batchSpins], third[batchSpins];
+	Xoshiro256 rng(1);
+
+	for (size_t i = 0; i < batchSpins; i++) {
+		first[i] = randomSymbol(rng);
+		second[i] = randomSymbol(rng);
+		third[i] = randomSymbol(rng);
+	}
+
+	Stats reference;
+	long long referencePoints = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (unsigned long long round = 0; round < rounds; round++) {
+		for (size_t i = 0; i < batchSpins; i++) {
+			referencePoints += scoreSpin(Symbol(first[i]), Symbol(second[i]), Symbol(third[i]), reference);
+		}
+	}
+	chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+
+	cout << "Scoring spins (" << rounds << " x " << batchSpins << " spins)" << endl;
+	cout << "  scoreSpin():  " << elapsed.count() / (rounds * batchSpins) << " ns/spin" << endl;
+
+	bool allSame = true;
+	for (unsigned short int level = 0; level <= simdLevel; level++) {
+		Stats tally;
+		long long points = 0;
+
+		start = chrono::steady_clock::now();
+		for (unsigned long long round = 0; round < rounds; round++) {
+			points += evaluateBatch(first, second, third, batchSpins, tally, SimdLevel(level));
+		}
+		elapsed = chrono::steady_clock::now() - start;
+
+		bool same = points == referencePoints && tally.jackpots == reference.jackpots && tally.twoSymbols == reference.twoSymbols && tally.diamonds == reference.diamonds && tally.total == reference.total
+			&& equal(tally.tiers, tally.tiers + PRIZES, reference.tiers);
+
+		cout << "  batch " << simdNames[level] << ":" << string(7 - strlen(simdNames[level]), ' ') << elapsed.count() / (rounds * batchSpins) << " ns/spin" << (same ? "" : "  (DIFFERENT RESULT!)") << endl;
+		allSame = allSame && same;
+	}
+	return allSame;
+}
+
+/**
+ * @brief Compares how long the Markov chain solver takes on every instruction set the CPU supports, and checks they all give the same result.
+ *
+ * @param horizon Number of games the solver follows.
+ * @return true If every instruction set gave the same result as the scalar version.
+ * @return false If one of them didn't.
+ */
+bool benchRuin(unsigned long long horizon) {
+
+	RuinSolution reference;
+	bool allSame = true;
+
+	cout << "Markov chain solver (" << startingCredit << " credits, " << horizon << " games)" << endl;
+
+	for (unsigned short int level = 0; level <= simdLevel; level++) {
+		auto start = chrono::steady_clock::now();
+		RuinSolution solution = solveRuin(startingCredit, horizon, SimdLevel(level));
+		chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+		if (level == 0) reference = solution;
+		bool same = solution.busted == reference.busted && solution.expectedLength == reference.expectedLength && solution.dropped == reference.dropped;
+
+		cout << "  " << simdNames[level] << ":" << string(7 - strlen(simdNames[level]), ' ') << elapsed.count() << " ms" << (same ? "" : "  (DIFFERENT RESULT!)") << endl;
+		allSame = allSame && same;
+	}
+	return allSame;
+}
+
+/**
+ * @brief Runs one benchmark of the suite and prints a line with its results: ns/op, ops/s, allocations/op and the 50th, 90th and 99th percentiles of the latency.
+ * The operation is timed in samples of a few operations each, because the fastest ones take less time than the clock can measure. The percentiles are worked out from the ns/op of each sample.
+ *
+ * @param name Name of the benchmark.
+ * @param samples Number of samples.
+ * @param batch Number of operations in each sample.
+ * @param operation Operation to measure.
+ * @return unsigned long long Returns the nr of heap allocations the measured operations made.
+ */
+template <typename Operation>
+unsigned long long benchmark(const char* name, unsigned long long samples, unsigned long long batch, Operation operation) {
+
+	vector<double> latencies; // ns/op of every sample
+	latencies.reserve(samples); // Reserved before measuring, so it isn't counted in the allocations
+
+	for (unsigned long long i = 0; i < batch; i++) { // Warm up
+		operation();
+	}
+
+	unsigned long long before = allocations;
+	auto start = chrono::steady_clock::now();
+
+	for (unsigned long long sample = 0; sample < samples; sample++) {
+		auto sampleStart = chrono::steady_clock::now();
+		for (unsigned long long i = 0; i < batch; i++) {
+			operation();
+		}
+		chrono::duration<double, nano> sampleTime = chrono::steady_clock::now() - sampleStart;
+		latencies.push_back(sampleTime.count() / batch);
+	}
+
+	chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+	unsigned long long allocated = allocations - before;
+	unsigned long long ops = samples * batch;
+
+	sort(latencies.begin(), latencies.end());
+
+	printf("  %-24s %10.2f %14.0f %10.3f %10.2f %10.2f %10.2f\n", name, elapsed.count() / ops, ops / (elapsed.count() / 1e9), (double)allocated / ops,
+		latencies[samples / 2], latencies[samples * 90 / 100], latencies[samples * 99 / 100]);
+
+	return allocated;
+}
+
+/**
+ * @brief Measures one frame of the rotating columns (drawRotCols(), without the wait) against a null terminal, i.e. a curses screen whose output is thrown away.
+ *
+ * @param frames Number of frames to measure.
+ */
+void benchFrame(unsigned long long frames) {
+
+	SpinState spin;
+
+#ifdef __PDCURSES__
+	constexpr bool countsBytes = false; // PDCurses ignores the output file of newterm() and draws on the console, so the bytes sent can't be counted
+#else
+	constexpr bool countsBytes = true;
+#endif
+
+	FILE* terminal = tmpfile(); // Fake terminal, its size tells how many bytes curses sent
+	SCREEN* screen = terminal ? newterm("vt100", terminal, stdin) : NULL;
+
+	if (screen == NULL) {
+		printf("  %-24s skipped (couldn't open a fake terminal)\n", "printRotCols() frame");
+		if (terminal) fclose(terminal);
+		return;
+	}
+
+	long sent = ftell(terminal);
+	benchmark("printFrame() repaint", 1000, 1, []() {
+		clearok(stdscr, TRUE); // What clear() used to do on every frame
+		printFrame();
+	});
+	long repaintBytes = ftell(terminal) - sent;
+
+	sent = ftell(terminal);
+	benchmark("printFrame()", 1000, 1, []() {
+		printFrame();
+	});
+	long layeredBytes = ftell(terminal) - sent;
+
+	if (countsBytes) printf("  %-24s %10.1f bytes/frame repainting, %.1f bytes/frame with the static layers\n", "", repaintBytes / 1001.0, layeredBytes / 1001.0); // 1000 samples and 1 warm up
+	else printf("  %-24s %10s bytes/frame not measured (PDCurses can't draw on a fake terminal)\n", "", "");
+
+	reelArea = ReelArea();
+
+	sent = ftell(terminal);
+	benchmark("printRotCols() frame", frames, 1, [&]() {
+		drawRotCols(spin);
+		advanceReels(spin, 0, 1);
+	});
+	benchmark("lockFirstCol() frame", frames, 1, [&]() {
+		drawRotCols(spin, 1);
+		advanceReels(spin, 1, 1);
+	});
+
+	if (countsBytes) printf("  %-24s %10.1f bytes/frame, %.1f cells/frame sent to the terminal by curses\n", "", (double)(ftell(terminal) - sent) / reelArea.frames, (double)reelArea.cells / reelArea.frames);
+	else printf("  %-24s %10s bytes/frame not measured, %.1f cells/frame sent to the console by curses\n", "", "", (double)reelArea.cells / reelArea.frames);
+	reelArea = ReelArea();
+
+#ifdef ANSI_REELS
+	fflush(terminal);
+	ansiReels.enabled = true;
+	ansiReels.output = fileno(terminal);
+
+	benchmark("printRotCols() ANSI", frames, 1, [&]() {
+		drawRotCols(spin);
+		advanceReels(spin, 0, 1);
+	});
+	benchmark("lockFirstCol() ANSI", frames, 1, [&]() {
+		drawRotCols(spin, 1);
+		advanceReels(spin, 1, 1);
+	});
+
+	printf("  %-24s %10.1f bytes/frame, %.1f cells/frame, %.2f write() calls/frame with the ANSI writer\n", "", (double)ansiReels.bytes / reelArea.frames, (double)reelArea.cells / reelArea.frames, (double)ansiReels.writes / reelArea.frames);
+	ansiReels = AnsiReels();
+	reelArea = ReelArea();
+#endif
+
+	freeLayers();
+	endwin();
+	delscreen(screen);
+	fclose(terminal);
+}
+
+/**
+ * @brief Plays whole spins the way a Normal Mode game does (slotMachine() and evalResult(), with the keys of an input script and the null renderer) and counts the heap allocations they make. A first spin is played before counting, so only the spins after the session started are checked.
+ *
+ * @param spins Number of spins to count.
+ * @return unsigned long long Returns the nr of heap allocations the spins made.
+ */
+unsigned long long benchScriptedSpins(int spins) {
+
+	SpinState spin;
+	FrameClock savedClock = frameClock; // The spins are drawn with the frame clock, so its stats are put back at the end
+	int savedFps = framesPerSecond;
+
+	for (int i = 0; i <= spins; i++) { // 3 keys to lock the columns, 2 frames apart, and one for the result. Created before counting
+		inputScript.events.push_back({ false, 2, 'a' });
+		inputScript.events.push_back({ false, 2, 'a' });
+		inputScript.events.push_back({ false, 2, 'a' });
+		inputScript.events.push_back({ false, 0, ' ' });
+	}
+	inputScript.active = true;
+	inputScript.lastFrame = frameClock.frames;
+	renderer.backend = NULL_RENDERER;
+	framesPerSecond = 1000;
+
+	evalResult(slotMachine(spin)); // The session starts
+
+	unsigned long long before = allocations;
+	auto start = chrono::steady_clock::now();
+
+	for (int i = 0; i < spins; i++) {
+		evalResult(slotMachine(spin));
+	}
+
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+	unsigned long long allocated = allocations - before;
+
+	cout << "Scripted spins (slotMachine() and evalResult() with the null renderer, " << spins << " spins)" << endl;
+	cout << "  " << elapsed.count() / spins << " ms/spin at " << framesPerSecond << " fps, " << (double)allocated / spins << " allocations/spin" << endl;
+
+	inputScript = InputScript();
+	renderer.backend = CURSES_RENDERER;
+	framesPerSecond = savedFps;
+	frameClock = savedClock;
+	reelArea = ReelArea();
+	return allocated;
+}
+
+/**
+ * @brief Benchmark suite for the hot paths of the game: generating a symbol, scoring a spin, a whole Ultra-Fast game, a frame of the rotating columns and the bookkeeping of evalResult(). Then it runs the before/after comparisons of the symbols, the random number generators and the batch evaluator.
+ * The comparisons of the batch evaluator and the Markov chain solver are also the only checks of their SIMD versions, so the suite fails if any of them gives a different result. It also fails if the spin path (scoring, an Ultra-Fast game, a frame of the rotating columns without the terminal, the bookkeeping and whole scripted spins) allocates memory on the heap.
+ *
+ * @return true If every SIMD version gave the same result as the scalar code and the spin path didn't allocate.
+ * @return false If one of them didn't.
+ */
+bool runBenchmarks() {
+
+	SpinState spin;
+	Reels reels;
+	for (Column& column : reels) {
+		fillColumn(column);
+	}
+
+	Stats savedStats = stats; // The benchmarks play with the global credit and stats, so they are put back at the end
+	int savedCredit = credit;
+	unsigned long long spinAllocations = 0; // Heap allocations of the spin path, which must not allocate once the session has started
+
+	printf("Benchmark suite (latency percentiles in ns/op)\n");
+	printf("  %-24s %10s %14s %10s %10s %10s %10s\n", "", "ns/op", "ops/s", "allocs/op", "p50", "p90", "p99");
+
+	benchmark("slotSymbols()", 10000, 1000, []() {
+		benchSink = benchSink + slotSymbols();
+	});
+	spinAllocations += benchmark("updateCredits()", 10000, 1000, [&]() {
+		reels[0][3] = slotSymbols(); // A different spin every time, otherwise the branch predictor would learn it
+		benchSink = benchSink + updateCredits(reels);
+	});
+	spinAllocations += benchmark("ultraFastMode()", 10000, 1000, []() {
+		ultraFastMode();
+	});
+	benchFrame(20000);
+
+	renderer.backend = NULL_RENDERER; // The same frames without drawing, to see what the game logic costs on its own
+	benchmark("printFrame() null", 10000, 100, []() {
+		printFrame();
+	});
+	spinAllocations += benchmark("printRotCols() null", 10000, 100, [&]() {
+		drawRotCols(spin);
+		advanceReels(spin, 0, 1);
+	});
+	renderer.backend = CURSES_RENDERER;
+	reelArea = ReelArea();
+	spinAllocations += benchmark("evalResult() bookkeeping", 10000, 1000, []() {
+		benchSink = benchSink + payPrize(prizePoints[slotSymbols() % PRIZES]);
+	});
+
+	cout << endl;
+	spinAllocations += benchScriptedSpins(20);
+
+	stats = savedStats;
+	credit = savedCredit;
+
+	benchSymbols(1000000);
+	benchRng(100000000);
+	bool same = benchEvaluate(10000);
+	same = benchRuin(10000) && same;
+
+	if (!same) cout << "A SIMD version gave a different result than the scalar code" << endl;
+	if (spinAllocations > 0) cout << "The spin path allocated memory on the heap" << endl;
+	return same && spinAllocations == 0;
+}
+
+/**
+ * @brief Prints the aggregated stats of many spins to the console, together with how fast they were played.
+ *
+ * @param title Title of the report.
+ * @param tally Stats of the spins.
+ * @param seconds How long it took to play them.
+ */
+void printReport(const string& title, const Stats& tally, double seconds) {
+
+	cout << title << endl;
+	for (const StatName& stat : statNames) {
+		cout << "  " << stat.name << " = " << tally.*stat.value << endl;
+	}
+
+	StatsSummary summary = summarizeStats(tally);
+
+	cout << "  Net per spin = " << summary.meanNet << " (standard deviation " << summary.deviation << ")" << endl;
+	cout << "  RTP = " << 100 * summary.rtp << "% +- " << 100 * summary.rtpMargin << "% (95% confidence interval)" << endl;
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		cout << "  " << prizeNames[prize] << " (" << prizePoints[prize] << "pts): " << tally.tiers[prize] << " = " << (tally.total > 0 ? 100.0 * tally.tiers[prize] / tally.total : 0) << "%" << endl;
+	}
+	cout << "Took " << seconds << " s (" << (unsigned long long)(seconds > 0 ? tally.total / seconds : 0) << " spins/s)" << endl;
+}
+
+/**
+ * @brief Prints how long the sessions lasted until the credit ran out.
+ *
+ * @param sessions Lengths of the sessions, in games.
+ */
+void printSessions(const LengthHistogram& sessions) {
+
+	if (sessions.values == 0) {
+		cout << "  No session ran out of credit" << endl;
+		return;
+	}
+	cout << "  " << sessions.values << " session(s) ran out of credit after " << histogramPercentile(sessions, 0.5) << " games (p50), " << histogramPercentile(sessions, 0.9) << " (p90), "
+		<< histogramPercentile(sessions, 0.99) << " (p99), " << sessions.longest << " at most" << endl;
+}
+
+/**
+ * @brief Runs the headless spin engine and prints the aggregated stats and the lengths of the sessions to the console.
+ *
+ * @param spins Number of spins to play.
+ * @param exportPath Optional parameter. CSV file where the histograms are exported, NULL to not export them.
+ */
+void runAudit(unsigned long long spins, const char* exportPath = NULL) {
+
+	LengthHistogram sessions;
+
+	auto start = chrono::steady_clock::now();
+	Stats tally = headlessSpins(spins, sessions);
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	printReport("Payout audit of " + to_string(spins) + " spin(s)", tally, elapsed.count());
+	printSessions(sessions);
+
+	if (exportPath != NULL && !exportHistograms(exportPath, tally, sessions)) cout << "Couldn't export the histograms to " << exportPath << endl;
+}
+
+/**
+ * @brief Works out the exact odds of the game and prints the RTP (return to player), the hit frequency, the probability of every prize and the variance of the prize.
+ *
+ */
+void runRtp() {
+
+	auto start = chrono::steady_clock::now();
+	Odds odds = exactOdds();
+	chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+
+	double mean = (double)odds.points / odds.outcomes;
+	double variance = (double)odds.squaredPoints / odds.outcomes - mean * mean;
+
+	cout << "Exact odds of the current paytable (" << odds.outcomes << " equally likely results, price " << price << ")" << endl;
+	cout << "  Expected prize = " << mean << " credits per spin (" << odds.points << "/" << odds.outcomes << ")" << endl;
+	cout << "  RTP = " << 100 * mean / price << "%" << endl;
+	cout << "  Hit frequency = " << 100.0 * (odds.outcomes - odds.ways[NO_PRIZE]) / odds.outcomes << "%" << endl;
+	cout << "  Variance of the prize = " << variance << " (standard deviation " << sqrt(variance) << ")" << endl;
+
+	for (unsigned short int prize = 0; prize < PRIZES; prize++) {
+		cout << "  " << prizeNames[prize] << " (" << prizePoints[prize] << "pts): " << odds.ways[prize] << "/" << odds.outcomes << " = " << 100.0 * odds.ways[prize] / odds.outcomes << "%" << endl;
+	}
+	cout << "Took " << elapsed.count() << " us" << endl;
+}
+
+/**
+ * @brief Runs the Markov chain solver and prints the probability of running out of credit by some games and the expected length of the session.
+ * With a game that takes more than it gives back, Wald's identity says the expected length of a whole session (with no horizon) is (starting credit - expected credit left) / expected loss per game, and the credit left is between 0 and the price, so the chain also bounds it.
+ *
+ * @param horizon Number of games to follow.
+ * @param startCredit Credit at the start of the session.
+ */
+void runRuin(unsigned long long horizon, long long startCredit) {
+
+	auto start = chrono::steady_clock::now();
+	RuinSolution solution = solveRuin(startCredit, horizon);
+	chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+	Odds odds = exactOdds();
+	double loss = price - (double)odds.points / odds.outcomes; // Expected loss per game
+	double bust = solution.busted[horizon];
+	double alive = 1 - bust - solution.dropped;
+
+	cout << "Exact session lengths from " << startCredit << " credits (Markov chain in steps of " << solution.step << " credits, up to " << horizon << " games)" << endl;
+	for (unsigned long long game = 1; game <= horizon; game = (game * 10 > horizon && game < horizon) ? horizon : game * 10) {
+		cout << "  P(out of credit by game " << game << ") = " << 100 * solution.busted[game] << "%" << endl;
+	}
+	cout << "  Still playing after " << horizon << " games = " << 100 * alive << "%" << endl;
+	cout << "  Expected length, stopping at game " << horizon << " = " << solution.expectedLength << " games" << endl;
+	if (loss > 0) {
+		double known = startCredit - solution.bustCredit; // Part of the starting credit already lost by the sessions that ran out of credit
+		double least = (known - (alive + solution.dropped) * (price - 1)) / loss;
+		double most = known / loss;
+		cout << "  Expected length of a whole session = " << least << " to " << most << " games (Wald's identity)" << endl;
+	}
+	cout << "  Error bound = " << solution.dropped << " (probability of the credits dropped below " << ruinEpsilon << ")" << endl;
+	cout << "Took " << elapsed.count() << " ms (" << solution.states << " states worked out with " << simdNames[simdLevel] << ")" << endl;
+}
+
+/**
+ * @brief Runs the multi-threaded simulator and prints the aggregated stats to the console.
+ * With a precision, the spins are played in rounds that double the spins played so far (1, 1, 2, 4... chunks), and the simulation stops as soon as the 95% confidence interval of the RTP is that narrow. The rounds are whole chunks, so the result is the same as simulating the spins that were played in one go.
+ *
+ * @param spins Number of spins to play (at most, with a precision).
+ * @param seed Seed of the simulation.
+ * @param threads Number of threads to use.
+ * @param precision Optional parameter. Half width of the confidence interval of the RTP, in %, that is enough to stop. 0 (default) plays all the spins.
+ */
+void runSimulation(unsigned long long spins, unsigned long long seed, unsigned int threads, double precision = 0) {
+
+	auto start = chrono::steady_clock::now();
+	Stats tally;
+	unsigned long long chunk = 0;       // First chunk of the next round
+	unsigned long long roundChunks = 1; // Chunks of the next round
+	bool converged = false;
+
+	if (precision <= 0) tally = simulateSpins(spins, seed, threads);
+
+	while (precision > 0 && (unsigned long long)tally.total < spins && !converged) {
+		mergeStats(tally, simulateSpins(min(roundChunks * chunkSpins, spins - tally.total), seed, threads, chunk));
+
+		chunk += roundChunks;
+		roundChunks = chunk;
+		converged = 100 * summarizeStats(tally).rtpMargin <= precision;
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	string title = "Simulation of " + to_string(tally.total) + " spin(s) with seed " + to_string(seed) + " (" + rngNames[rngEngine] + ") on " + to_string(threads) + " thread(s)";
+	if (converged) {
+		char known[64];
+		snprintf(known, sizeof(known), ", stopped early because the RTP is known to +-%g%%", precision);
+		title += known;
+	}
+
+	printReport(title, tally, elapsed.count());
+}
+
+/**
+ * @brief Runs the session simulator and prints how long the sessions lasted, how high the credit got and how often the target was reached.
+ *
+ * @param sessions Number of sessions to play.
+ * @param seed Seed of the simulation.
+ * @param threads Number of threads to use.
+ * @param settings Starting credit, spin cap and target of the sessions.
+ * @param exportPath Optional parameter. CSV file where the histograms are exported, NULL to not export them.
+ */
+void runSessions(unsigned long long sessions, unsigned long long seed, unsigned int threads, const SessionSettings& settings, const char* exportPath = NULL) {
+
+	auto start = chrono::steady_clock::now();
+	SessionResults results = simulateSessionRuns(sessions, seed, threads, settings);
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+	printReport("Simulation of " + to_string(sessions) + " session(s) starting with " + to_string(settings.startCredit) + " credits, up to " + to_string(settings.spinCap) + " games each, with seed " + to_string(seed) + " (" + rngNames[rngEngine] + ") on " + to_string(threads) + " thread(s)", results.tally, elapsed.count());
+
+	double reached = (double)results.reached / max(results.sessions, 1ULL);
+	double margin = 1.96 * sqrt(reached * (1 - reached) / max(results.sessions, 1ULL));
+
+	cout << "  " << results.busted << " session(s) ran out of credit and " << results.capped << " reached the cap of " << settings.spinCap << " games" << endl;
+	printSessions(results.lengths);
+	cout << "  Highest credit of a session: " << histogramPercentile(results.peaks, 0.5) << " (p50), " << histogramPercentile(results.peaks, 0.9) << " (p90), " << histogramPercentile(results.peaks, 0.99) << " (p99), " << results.peaks.longest << " at most" << endl;
+	cout << "  Probability of reaching " << settings.target << " credits = " << 100 * reached << "% +- " << 100 * margin << "% (95% confidence interval)" << endl;
+	cout << "  " << (unsigned long long)(elapsed.count() > 0 ? results.sessions / elapsed.count() : 0) << " sessions/s" << endl;
+
+	if (exportPath != NULL && !exportHistograms(exportPath, results.tally, results.lengths, &results.peaks)) cout << "Couldn't export the histograms to " << exportPath << endl;
+}
+
+/**
+ * @brief Summary of a recording, to see how much it costs to draw the game.
+ *
+ */
+struct RecordingSummary {
+	unsigned long long frames = 0;        // Nr of frames
+	unsigned long long operations = 0;    // Nr of drawing operations
+	unsigned long long textBytes = 0;     // Nr of characters of text drawn
+	unsigned long long repaints = 0;      // Nr of times the whole screen was repainted
+	unsigned long long maxFrameBytes = 0; // Characters of text of the most expensive frame
+	double seconds = 0;                   // Time between the start of the recording and the last frame
+};
+
+/**
+ * @brief One drawing operation of a recording (see Renderer for the format).
+ *
+ */
+struct RecordOperation {
+	int type;                     // 'T', 'M', 'L', 'E', 'C' or 'F', EOF at the end of the recording
+	unsigned long long line = 0;   // Line of 'T', 'M' and 'L'
+	unsigned long long column = 0; // Column of 'T' and 'M'
+	unsigned long long time = 0;   // Microseconds since the start of the recording of 'F'
+	string text;                   // Text of 'T' and 'M'
+};
+
+/**
+ * @brief Opens a recording and checks its header.
+ *
+ * @param path Recording to open.
+ * @return FILE* Returns the file, positioned on the first operation, or NULL if it couldn't be opened or isn't a recording.
+ */
+FILE* openRecording(const char* path) {
+
+	FILE* file = fopen(path, "rb");
+	char header[11] = {};
+
+	if (file == NULL) return NULL;
+
+	if (fread(header, 1, 10, file) != 10 || strncmp(header, "FMREC2", 6) != 0) { // "FMREC2" and the size of the screen
+		fclose(file);
+		return NULL;
+	}
+	return file;
+}
+
+/**
+ * @brief Reads a number written by recordNumber().
+ *
+ * @param file Recording to read from.
+ * @param bytes Nr of bytes of the number, least significant first.
+ * @param value Where the number is read to.
+ * @return true If the number was read.
+ * @return false If the recording is cut short.
+ */
+bool readNumber(FILE* file, int bytes, unsigned long long& value) {
+
+	value = 0;
+	for (int i = 0; i < bytes; i++) {
+		int byte = getc(file);
+
+		if (byte == EOF) return false;
+		value |= (unsigned long long)byte << (8 * i);
+	}
+	return true;
+}
+
+/**
+ * @brief Reads the next operation of a recording.
+ *
+ * @param file Recording to read from.
+ * @param operation Where the operation is read to.
+ * @return true If an operation was read, or the recording is over (the type is EOF).
+ * @return false If the recording is cut short or broken.
+ */
+bool readOperation(FILE* file, RecordOperation& operation) {
+
+	operation.type = getc(file);
+
+	if (operation.type == 'T' || operation.type == 'M') {
+		unsigned long long length;
+
+		if (!readNumber(file, 2, operation.line) || !readNumber(file, 2, operation.column) || !readNumber(file, 2, length)) return false;
+		operation.text.resize((size_t)length);
+		return length == 0 || fread(&operation.text[0], 1, (size_t)length, file) == length;
+	}
+	if (operation.type == 'L') return readNumber(file, 2, operation.line);
+	if (operation.type == 'F') return readNumber(file, 8, operation.time);
+
+	return operation.type == 'E' || operation.type == 'C' || operation.type == EOF;
+}
+
+/**
+ * @brief Reads a recording made with --record and adds up what it cost to draw. It can also show it on the screen with the same timing it was recorded with.
+ *
+ * @param path Recording to read.
+ * @param show True to play it back on the screen (curses has to be started), false to only read it.
+ * @param summary Where the costs are added up.
+ * @return true If the recording was read until the end.
+ * @return false If the file couldn't be opened or isn't a recording.
+ */
+bool readRecording(const char* path, bool show, RecordingSummary& summary) {
+
+	FILE* file = openRecording(path);
+
+	if (file == NULL) return false;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	unsigned long long frameBytes = 0;
+	RecordOperation operation;
+	bool complete;
+
+	while ((complete = readOperation(file, operation)) && operation.type != EOF) {
+		if (operation.type == 'F') {
+			if (show) {
+				this_thread::sleep_until(start + chrono::microseconds(operation.time));
+				renderPresent();
+			}
+			summary.frames++;
+			summary.textBytes += frameBytes;
+			summary.maxFrameBytes = max(summary.maxFrameBytes, frameBytes);
+			summary.seconds = operation.time / 1e6;
+			frameBytes = 0;
+			continue;
+		}
+
+		if (operation.type == 'T' || operation.type == 'M') {
+			frameBytes += operation.text.size();
+			if (show) renderText((int)operation.line, (int)operation.column, operation.text.c_str());
+		}
+		else if (operation.type == 'L') {
+			if (show) clearLine((int)operation.line);
+		}
+		else if (operation.type == 'E') {
+			if (show) renderErase();
+		}
+		else { // 'C'
+			summary.repaints++;
+			if (show) renderClear();
+		}
+		summary.operations++;
+	}
+
+	fclose(file);
+	return complete;
+}
+
+/**
+ * @brief Compares two recordings frame by frame, e.g. of the same input script and seed played by two builds. The times of the frames are not compared, and neither is the text of the measured values (see renderMeasured).
+ *
+ * @param first First recording.
+ * @param second Second recording.
+ * @return int Returns the exit code of the program: 0 if they draw the same frames, 1 if they don't or can't be read.
+ */
+int compareRecordings(const char* first, const char* second) {
+
+	FILE* files[2] = { openRecording(first), openRecording(second) };
+
+	if (files[0] == NULL || files[1] == NULL) {
+		cout << "Couldn't read the recording " << (files[0] == NULL ? first : second) << endl;
+		for (FILE* file : files) if (file) fclose(file);
+		return 1;
+	}
+
+	RecordOperation operations[2];
+	unsigned long long frames = 0;
+	bool same = true;
+
+	while (true) {
+		bool complete = readOperation(files[0], operations[0]);
+		complete = readOperation(files[1], operations[1]) && complete;
+
+		const RecordOperation& a = operations[0];
+		const RecordOperation& b = operations[1];
+
+		same = complete && a.type == b.type;
+		if (same && a.type == 'T') same = a.line == b.line && a.column == b.column && a.text == b.text;
+		if (same && a.type == 'M') same = a.line == b.line && a.column == b.column; // Measurements are only compared by where they are
+		if (same && a.type == 'L') same = a.line == b.line;
+
+		if (!same || a.type == EOF) break;
+		if (a.type == 'F') frames++;
+	}
+
+	fclose(files[0]);
+	fclose(files[1]);
+
+	if (same) cout << "The recordings draw the same " << frames << " frames" << endl;
+	else {
+		cout << "The recordings are different from frame " << frames + 1 << " on" << endl;
+
+		if (operations[0].type == 'T' && operations[1].type == 'T') { // Shows the first text that is different
+			cout << "  " << operations[0].text << endl;
+			cout << "  " << operations[1].text << endl;
+		}
+	}
+	return same ? 0 : 1;
+}
+
+/**
+ * @brief Plays back a recording made with --record and then prints what it cost to draw it.
+ *
+ * @param path Recording to play back.
+ * @return int Returns the exit code of the program.
+ */
+int runPlayback(const char* path) {
+
+	RecordingSummary summary;
+
+	initscr();
+	noecho();
+	curs_set(0);
+
+	bool complete = readRecording(path, true, summary);
+
+	freeLayers();
+	endwin();
+
+	if (summary.frames == 0 && !complete) {
+		cout << "Couldn't read the recording " << path << endl;
+		return 1;
+	}
+	cout << "Recording " << path << (complete ? "" : " (cut short)") << endl;
+	cout << "  " << summary.frames << " frames in " << summary.seconds << " s, " << summary.operations << " drawing operations, " << summary.repaints << " full repaints" << endl;
+	cout << "  " << (double)summary.textBytes / max(summary.frames, 1ULL) << " characters of text per frame on average, " << summary.maxFrameBytes << " in the most expensive frame" << endl;
+	return 0;
+}
+
+/**
+ * @brief Main function of the tools. It runs the tool chosen in the command line and exits.
+ * "--audit N" plays N spins with the headless spin engine and prints the stats.
+ * "--simulate N" plays N spins with the multi-threaded simulator ("--seed S" and "--threads T" can be used to choose the seed and the nr of threads, "--precision P" stops it as soon as the RTP is known to +-P%).
+ * "--sessions N" plays N whole sessions with the multi-threaded session simulator ("--credit C", "--cap S" and "--target T" choose the starting credit, the spin cap and the target balance).
+ * "--ruin N" works out the exact probability of running out of credit by each of the first N games and the expected length of a session with the Markov chain solver ("--credit C" chooses the starting credit).
+ * "--rtp" works out the exact RTP and odds of the game and prints them.
+ * "--bench" runs the benchmark suite, and exits with 1 if a SIMD version of the batch evaluator or the Markov chain solver gives a different result than the scalar code, or if the spin path (including whole scripted spins) allocates memory on the heap.
+ * "--playback FILE" plays back a recording of the game and prints what it cost to draw.
+ * "--compare A B" compares two recordings of the game frame by frame.
+ * "--export FILE" writes the payout and session length histograms of --audit or --sessions to a CSV file.
+ * "--rng xoshiro" or "--rng philox" chooses the random number generator used by the simulators.
+ *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments.
+ * @return int
+ */
+int main(int argc, char* argv[]) {
+
+	string mode;                                                // Tool chosen in the command line
+	unsigned long long spins = 0;                               // Nr of spins for --audit and --simulate, nr of sessions for --sessions, nr of games for --ruin
+	unsigned long long seed = (unsigned long long)time(NULL);   // Random seed, the current time unless --seed is used
+	unsigned int threads = max(thread::hardware_concurrency(), 1u); // Nr of threads for --simulate and --sessions, all the cores unless --threads is used
+	const char* recording = NULL;                               // File for --playback and --compare
+	const char* otherRecording = NULL;                          // Second file for --compare
+	double precision = 0;                                       // Precision of the RTP that stops --simulate early, 0 to play all the spins
+	const char* exportPath = NULL;                              // CSV file for --export
+	SessionSettings sessionSettings;                            // Starting credit, spin cap and target of --sessions (starting credit of --ruin)
+
+	for (int i = 1; i < argc; i++) {
+		string option = argv[i];
+
+		if ((option == "--audit" || option == "--simulate" || option == "--sessions" || option == "--ruin") && i + 1 < argc) {
+			mode = option;
+			spins = strtoull(argv[++i], NULL, 10);
+		}
+		else if (option == "--bench" || option == "--rtp") mode = option;
+		else if (option == "--playback" && i + 1 < argc) {
+			mode = option;
+			recording = argv[++i];
+		}
+		else if (option == "--compare" && i + 2 < argc) {
+			mode = option;
+			recording = argv[++i];
+			otherRecording = argv[++i];
+		}
+		else if (option == "--export" && i + 1 < argc) exportPath = argv[++i];
+		else if (option == "--credit" && i + 1 < argc) sessionSettings.startCredit = max(atoll(argv[++i]), 0LL);
+		else if (option == "--cap" && i + 1 < argc) sessionSettings.spinCap = strtoull(argv[++i], NULL, 10);
+		else if (option == "--target" && i + 1 < argc) sessionSettings.target = atoll(argv[++i]);
+		else if (option == "--precision" && i + 1 < argc) precision = max(atof(argv[++i]), 0.0);
+		else if (option == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+		else if (option == "--threads" && i + 1 < argc) threads = max((unsigned int)strtoul(argv[++i], NULL, 10), 1u);
+		else if (option == "--rng" && i + 1 < argc) {
+			string name = argv[++i];
+
+			if (!chooseRng(name)) {
+				cout << "Unknown random number generator: " << name << endl;
+				return 1;
+			}
+		}
+		else {
+			cout << "Unknown option: " << option << endl;
+			return 1;
+		}
+	}
+
+	xoshiroRng = Xoshiro256(seed);
+	philoxRng = Philox4x32(seed);
+
+	if (mode == "--audit") {
+		runAudit(spins, exportPath);
+		return 0;
+	}
+	if (mode == "--simulate") {
+		runSimulation(spins, seed, threads, precision);
+		return 0;
+	}
+	if (mode == "--sessions") {
+		runSessions(spins, seed, threads, sessionSettings, exportPath);
+		return 0;
+	}
+	if (mode == "--ruin") {
+		runRuin(spins, sessionSettings.startCredit);
+		return 0;
+	}
+	if (mode == "--rtp") {
+		runRtp();
+		return 0;
+	}
+	if (mode == "--bench") {
+		return runBenchmarks() ? 0 : 1;
+	}
+	if (mode == "--playback") {
+		return runPlayback(recording);
+	}
+	if (mode == "--compare") {
+		return compareRecordings(recording, otherRecording);
+	}
+
+	cout << "Usage: FruitMachineTools --audit N | --simulate N | --sessions N | --ruin N | --rtp | --bench | --playback FILE | --compare A B" << endl;
+	return 1;
+}